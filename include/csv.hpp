@@ -29,6 +29,8 @@ SOFTWARE.
 #ifndef CSV_HPP
 #define CSV_HPP
 
+#include "internal/csv_multi_reader.hpp"
+#include "internal/csv_push_parser.hpp"
 #include "internal/csv_reader.hpp"
 #include "internal/csv_stat.hpp"
 #include "internal/csv_utility.hpp"
@@ -1,4 +1,12 @@
 #include "basic_csv_parser.hpp"
+#include "csv_decompress.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#define CSV_HAS_MADVISE
+#endif
 
 namespace csv {
     namespace internals {
@@ -12,11 +20,15 @@ namespace csv {
         }
 
         CSV_INLINE std::string get_csv_head(csv::string_view filename) {
+            const auto compression = detect_compression(filename);
+            if (compression != Compression::NONE)
+                return decompress_head(filename, compression, GUESS_HEAD_SIZE);
+
             return get_csv_head(filename, get_file_size(filename));
         }
 
         CSV_INLINE std::string get_csv_head(csv::string_view filename, size_t file_size) {
-            const size_t bytes = 500000;
+            const size_t bytes = GUESS_HEAD_SIZE;
 
             std::error_code error;
             size_t length = std::min((size_t)file_size, bytes);
@@ -29,6 +41,65 @@ namespace csv {
             return std::string(mmap.begin(), mmap.end());
         }
 
+        CSV_INLINE void run_parallel(Executor& executor, size_t n_tasks, const std::function<void(size_t)>& task) {
+            if (n_tasks == 0) return;
+
+            TaskGroup group;
+            for (size_t i = 1; i < n_tasks; i++)
+                executor.submit(group, [&task, i]() { task(i); });
+
+            std::exception_ptr error = nullptr;
+            try {
+                task(0);
+            }
+            catch (...) {
+                error = std::current_exception();
+            }
+
+            try {
+                executor.wait(group);
+            }
+            catch (...) {
+                if (!error) error = std::current_exception();
+            }
+
+            if (error) std::rethrow_exception(error);
+        }
+
+        CSV_INLINE size_t find_row_start(csv::string_view in, size_t pos, bool quoted, const StructuralChars& chars) noexcept {
+            auto is_newline = [](char ch) { return ch == '\r' || ch == '\n'; };
+
+            for (size_t i = pos; i < in.size(); i++) {
+                if (i > 0 && !quoted && is_newline(in[i - 1]) && !is_newline(in[i]))
+                    return i;
+
+                if (chars.use_quote && in[i] == chars.quote)
+                    quoted = !quoted;
+            }
+
+            return in.size();
+        }
+
+        CSV_INLINE std::vector<size_t> resolve_columns(const std::vector<std::string>& col_names, const CSVFormat& format) {
+            std::vector<size_t> selected = format.get_selected_indices();
+
+            for (auto& name : format.get_selected_names()) {
+                auto it = std::find(col_names.begin(), col_names.end(), name);
+                if (it == col_names.end())
+                    throw std::runtime_error("Can't find a column named " + name);
+
+                selected.push_back((size_t)(it - col_names.begin()));
+            }
+
+            std::sort(selected.begin(), selected.end());
+            selected.erase(std::unique(selected.begin(), selected.end()), selected.end());
+
+            if (!selected.empty() && selected.back() >= col_names.size())
+                throw std::runtime_error("Column index " + std::to_string(selected.back()) + " is out of bounds.");
+
+            return selected;
+        }
+
 #ifdef _MSC_VER
 #pragma region IBasicCVParser
 #endif
@@ -46,13 +117,84 @@ namespace csv {
             _ws_flags = internals::make_ws_flags(
                 format.trim_chars.data(), format.trim_chars.size()
             );
+
+            this->set_special_chars();
+
+            if (format.has_column_selection() || !format.row_filters.empty()) {
+                _selection.enabled = true;
+                _selection.project = format.has_column_selection();
+                _selection.filters = format.row_filters;
+                _selection.header = format.header;
+                _selection.policy = format.variable_column_policy;
+
+                if (!format.col_names.empty())
+                    _selection.n_cols = format.col_names.size();
+            }
+
+            if (_selection.project) {
+                if (!format.col_names.empty()) {
+                    _selection.set_columns(resolve_columns(format.col_names, format));
+                }
+                else if (!format.selected_indices.empty()) {
+                    std::vector<size_t> selected = format.selected_indices;
+                    std::sort(selected.begin(), selected.end());
+                    selected.erase(std::unique(selected.begin(), selected.end()), selected.end());
+                    _selection.set_columns(selected);
+                }
+                else if (format.header < 0) {
+                    throw std::runtime_error("Columns can only be selected by name if the CSV has a header row or column names.");
+                }
+                else {
+                    _selection.names = format.selected_names;
+                }
+            }
+        }
+
+        CSV_INLINE void IBasicCSVParser::set_special_chars() {
+            size_t n_special = 0, n_quote = 0;
+
+            for (int i = -128; i < 128; i++) {
+                const char ch = char(i);
+                const ParseFlags flag = parse_flag(ch);
+
+                if (flag != ParseFlags::NOT_SPECIAL && n_special < _special_chars.size())
+                    _special_chars[n_special++] = ch;
+
+                if (flag == ParseFlags::QUOTE && n_quote < _quote_chars.size())
+                    _quote_chars[n_quote++] = ch;
+            }
+
+            // Pad out unused slots by repeating characters already in the set
+            for (size_t i = n_special; i < _special_chars.size(); i++)
+                _special_chars[i] = n_special ? _special_chars[0] : '\n';
+
+            for (size_t i = n_quote; i < _quote_chars.size(); i++)
+                _quote_chars[i] = n_quote ? _quote_chars[0] : _special_chars[0];
+
+            // The bitmap engine does not handle whitespace trimming
+            bool has_delim = false, trim = false;
+            for (int i = -128; i < 128; i++) {
+                const char ch = char(i);
+                trim |= ws_flag(ch);
+
+                if (parse_flag(ch) == ParseFlags::DELIMITER) {
+                    _structural_chars.delim = ch;
+                    has_delim = true;
+                }
+            }
+
+            _structural_chars.quote = _quote_chars[0];
+            _structural_chars.use_quote = n_quote > 0;
+            _use_bitmap_engine = has_delim && !trim;
+
+            const char sep = has_delim ? _structural_chars.delim : '\n';
+            _separator_chars = SpecialChars{{ sep, '\r', '\n', sep }};
         }
 
         CSV_INLINE void IBasicCSVParser::end_feed() {
             using internals::ParseFlags;
 
             bool empty_last_field = this->data_ptr
-                && this->data_ptr->_data
                 && !this->data_ptr->data.empty()
                 && (parse_flag(this->data_ptr->data.back()) == ParseFlags::DELIMITER
                     || parse_flag(this->data_ptr->data.back()) == ParseFlags::QUOTE);
@@ -67,37 +209,15 @@ namespace csv {
                 this->push_row();
         }
 
-        CSV_INLINE void IBasicCSVParser::parse_field() noexcept {
-            using internals::ParseFlags;
-            auto& in = this->data_ptr->data;
-
-            // Trim off leading whitespace
-            while (data_pos < in.size() && ws_flag(in[data_pos]))
-                data_pos++;
-
-            if (field_start == UNINITIALIZED_FIELD)
-                field_start = (int)(data_pos - current_row_start());
-
-            // Optimization: Since NOT_SPECIAL characters tend to occur in contiguous
-            // sequences, use the loop below to avoid having to go through the outer
-            // switch statement as much as possible
-            while (data_pos < in.size() && compound_parse_flag(in[data_pos]) == ParseFlags::NOT_SPECIAL)
-                data_pos++;
-
-            field_length = data_pos - (field_start + current_row_start());
-
-            // Trim off trailing whitespace, this->field_length constraint matters
-            // when field is entirely whitespace
-            for (size_t j = data_pos - 1; ws_flag(in[j]) && this->field_length > 0; j--)
-                this->field_length--;
-        }
-
         CSV_INLINE void IBasicCSVParser::push_field()
         {
             // Update
-            if (field_has_double_quote) {
+            if (_selection.project && !_selection.keep_field()) {
+                field_has_double_quote = false;
+            }
+            else if (field_has_double_quote) {
                 fields->emplace_back(
-                    field_start == UNINITIALIZED_FIELD ? 0 : (unsigned int)field_start,
+                    field_start == UNINITIALIZED_FIELD ? 0 : field_start,
                     field_length,
                     true
                 );
@@ -106,7 +226,7 @@ namespace csv {
             }
             else {
                 fields->emplace_back(
-                    field_start == UNINITIALIZED_FIELD ? 0 : (unsigned int)field_start,
+                    field_start == UNINITIALIZED_FIELD ? 0 : field_start,
                     field_length
                 );
             }
@@ -123,85 +243,157 @@ namespace csv {
         {
             using internals::ParseFlags;
 
-            this->quote_escape = false;
-            this->data_pos = 0;
-            this->current_row_start() = 0;
-            this->trim_utf8_bom();
+            if (this->_suspended) {
+                if (!this->resume_row())
+                    return this->current_row_start();
+            }
+            else {
+                // Each chunk starts at the beginning of a row, so discard any
+                // state belonging to a partial row at the end of the last chunk
+                this->quote_escape = false;
+                this->field_start = UNINITIALIZED_FIELD;
+                this->field_length = 0;
+                this->field_has_double_quote = false;
+                this->data_pos = 0;
+                this->current_row_start() = 0;
+                this->_selection.row_fields = 0;
+                this->trim_utf8_bom();
+            }
 
-            auto& in = this->data_ptr->data;
-            while (this->data_pos < in.size()) {
-                switch (compound_parse_flag(in[this->data_pos])) {
-                case ParseFlags::DELIMITER:
-                    this->push_field();
-                    this->data_pos++;
-                    break;
+            return (this->*_parse_dialect)();
+        }
 
-                case ParseFlags::NEWLINE:
-                    this->data_pos++;
+        CSV_INLINE void IBasicCSVParser::push_row() {
+            current_row.row_length = fields->size() - current_row.fields_start;
+            if (_selection.enabled && !this->select_row())
+                return;
 
-                    // Catches CRLF (or LFLF, CRCRLF, or any other non-sensical combination of newlines)
-                    while (this->data_pos < in.size() && parse_flag(in[this->data_pos]) == ParseFlags::NEWLINE)
-                        this->data_pos++;
+            this->_rows_pushed++;
+            this->_fields_pushed += current_row.size();
+            this->emit_row(std::move(current_row));
+        }
 
-                    // End of record -> Write record
-                    this->push_field();
-                    this->push_row();
+        CSV_INLINE bool IBasicCSVParser::select_row() {
+            auto& selection = this->_selection;
+            const size_t n_fields = selection.project ? selection.row_fields : current_row.size();
+            selection.row_fields = 0;
 
-                    // Reset
-                    this->current_row = CSVRow(data_ptr, this->data_pos, fields->size());
-                    break;
+            // Rows before the header are dropped by CSVReader
+            if ((int)selection.rows_seen < selection.header) {
+                selection.rows_seen++;
+                return true;
+            }
 
-                case ParseFlags::NOT_SPECIAL:
-                    this->parse_field();
-                    break;
+            if ((int)selection.rows_seen == selection.header) {
+                selection.rows_seen++;
+                selection.n_cols = n_fields;
 
-                case ParseFlags::QUOTE_ESCAPE_QUOTE:
-                    if (data_pos + 1 == in.size()) return this->current_row_start();
-                    else if (data_pos + 1 < in.size()) {
-                        auto next_ch = parse_flag(in[data_pos + 1]);
-                        if (next_ch >= ParseFlags::DELIMITER) {
-                            quote_escape = false;
-                            data_pos++;
-                            break;
-                        }
-                        else if (next_ch == ParseFlags::QUOTE) {
-                            // Case: Escaped quote
-                            data_pos += 2;
-                            this->field_length += 2;
-                            this->field_has_double_quote = true;
-                            break;
-                        }
-                    }
-                    
-                    // Case: Unescaped single quote => not strictly valid but we'll keep it
-                    this->field_length++;
-                    data_pos++;
+                if (selection.project && !selection.active()) {
+                    // Now that we know the column names, push the selected
+                    // header fields again and point the header row at them
+                    std::vector<std::string> header = current_row;
+                    selection.set_columns(resolve_columns(header, CSVFormat().select_columns(selection.names)));
 
-                    break;
+                    const size_t header_start = current_row.fields_start;
+                    current_row.fields_start = fields->size();
+                    for (auto i : selection.columns)
+                        fields->emplace_back((*fields)[header_start + i]);
+
+                    current_row.row_length = selection.columns.size();
+                }
+                else if (selection.project && selection.columns.back() >= n_fields) {
+                    throw std::runtime_error("Column index " + std::to_string(selection.columns.back()) + " is out of bounds.");
+                }
 
-                default: // Quote (currently not quote escaped)
-                    if (this->field_length == 0) {
-                        quote_escape = true;
-                        data_pos++;
-                        if (field_start == UNINITIALIZED_FIELD && data_pos < in.size() && !ws_flag(in[data_pos]))
-                            field_start = (int)(data_pos - current_row_start());
-                        break;
-                    }
+                // Filters may look up fields by name before CSVReader has seen the header
+                if (!selection.filters.empty() && this->_col_names && this->_col_names->empty())
+                    this->_col_names->set_col_names(current_row);
 
-                    // Case: Unescaped quote
-                    this->field_length++;
-                    data_pos++;
+                return true;
+            }
 
-                    break;
+            // Without a header or column names, the first row determines the number of columns
+            if (selection.n_cols == 0)
+                selection.n_cols = n_fields;
+
+            if (n_fields != selection.n_cols && selection.policy != VariableColumnPolicy::KEEP) {
+                // Rows of the wrong length are left for CSVReader to deal with,
+                // unless we have skipped some of their fields
+                if (!selection.project)
+                    return true;
+
+                if (selection.policy == VariableColumnPolicy::THROW) {
+                    throw std::runtime_error(
+                        std::string(n_fields < selection.n_cols ? "Line too short" : "Line too long")
+                        + ": expected " + std::to_string(selection.n_cols)
+                        + " fields but found " + std::to_string(n_fields));
                 }
+
+                return false;
+            }
+
+            for (auto& filter : selection.filters) {
+                if (!filter(current_row))
+                    return false;
             }
 
-            return this->current_row_start();
+            return true;
         }
 
-        CSV_INLINE void IBasicCSVParser::push_row() {
-            current_row.row_length = fields->size() - current_row.fields_start;
-            this->_records->push_back(std::move(current_row));
+        CSV_INLINE void IBasicCSVParser::suspend_row() {
+            // Until the search for a byte order mark is over, chunks have to be
+            // parsed from the beginning
+            if (!this->unicode_bom_scan) return;
+
+            this->_suspended_fields.clear();
+            for (size_t i = this->current_row.fields_start; i < this->fields->size(); i++)
+                this->_suspended_fields.push_back((*this->fields)[i]);
+
+            this->_suspended_pos = this->data_pos - this->current_row_start();
+            this->_suspended = true;
+        }
+
+        CSV_INLINE bool IBasicCSVParser::resume_row() {
+            this->_suspended = false;
+
+            // Field positions are relative to the beginning of the row, so
+            // they stay the same in a chunk which begins with that row
+            this->current_row = CSVRow(this->data_ptr, 0, 0);
+            for (auto& field : this->_suspended_fields)
+                this->fields->emplace_back(field);
+
+            this->current_row.row_length = this->_suspended_fields.size();
+            this->data_pos = this->_suspended_pos;
+
+            // Where a field begins depends on characters the last chunk ended before:
+            auto& in = this->data_ptr->data;
+            if (this->field_length == 0 && this->field_start == this->data_pos) {
+                // Leading whitespace may continue in this chunk
+                while (this->data_pos < in.size() && this->ws_flag(in[this->data_pos]))
+                    this->data_pos++;
+
+                this->field_start = this->data_pos;
+            }
+            else if (this->quote_escape && this->field_start == UNINITIALIZED_FIELD && this->field_length == 0
+                && this->data_pos < in.size() && !this->ws_flag(in[this->data_pos])) {
+                // The opening quote was the last character
+                this->field_start = this->data_pos;
+            }
+
+            if (!this->field_in_progress())
+                return true;
+
+            // Finish the interrupted field one character at a time, so that
+            // the faster engines in parse() can start from a field boundary
+            this->_finish_field_only = true;
+            (this->*_state_machine)();
+
+            if (this->_finish_field_only) {
+                this->_finish_field_only = false;
+                return false;
+            }
+
+            return true;
         }
 
         CSV_INLINE void IBasicCSVParser::reset_data_ptr() {
@@ -230,34 +422,443 @@ namespace csv {
 #ifdef _MSC_VER
 #pragma region Specializations
 #endif
-        CSV_INLINE void MmapParser::next(size_t bytes = ITERATION_CHUNK_SIZE) {
-            // Reset parser state
-            this->field_start = UNINITIALIZED_FIELD;
-            this->field_length = 0;
+        CSV_INLINE std::shared_ptr<std::string> IStreamParser::begin_chunk(size_t& length) {
+            std::shared_ptr<std::string> buffer = nullptr;
+            for (auto it = _recent_chunks.begin(); it != _recent_chunks.end(); ++it) {
+                // No CSVRow or other chunk, and so no other thread, can still be using this buffer
+                if (it->use_count() == 1 && (*it)->_data.use_count() == 1) {
+                    buffer = std::static_pointer_cast<std::string>((*it)->_data);
+                    _recent_chunks.erase(it);
+                    _recycled_chunks++;
+                    break;
+                }
+            }
+
+            if (!buffer)
+                buffer = std::make_shared<std::string>();
+
+            length = 0;
+            append_chunk(*buffer, length, _carry.data(), _carry.size());
+            return buffer;
+        }
+
+        CSV_INLINE void IStreamParser::append_chunk(std::string& buffer, size_t& length, const char* data, size_t n) {
+            if (buffer.size() < length + n)
+                buffer.resize(length + n);
+
+            if (n > 0)
+                std::memcpy(&buffer[length], data, n);
+
+            length += n;
+        }
+
+        CSV_INLINE size_t IStreamParser::parse_chunk(const std::shared_ptr<std::string>& buffer, csv::string_view data, bool last) {
+            // If the last chunk ended with a complete row, skip the rest of its newline
+            // run (e.g. the LF of a CRLF) so it isn't mistaken for an empty row
+            if (_skip_newlines) {
+                while (!data.empty() && parse_flag(data.front()) == ParseFlags::NEWLINE)
+                    data.remove_prefix(1);
+            }
+
             this->reset_data_ptr();
+            this->data_ptr->_data = buffer;
+            this->data_ptr->data = data;
 
-            // Create memory map
-            size_t length = std::min(this->source_size - this->mmap_pos, bytes);
+            // Parse
+            this->current_row = CSVRow(this->data_ptr);
+            size_t remainder = this->parse();
+
+            if (last) {
+                this->_eof = true;
+                this->end_feed();
+            }
+            else {
+                _carry = data.substr(remainder);
+                if (!_carry.empty())
+                    this->suspend_row();
+
+                // If nothing was consumed, the same data will be parsed again
+                if (remainder > 0)
+                    _skip_newlines = _carry.empty();
+            }
+
+            _recent_chunks.push_back(this->data_ptr);
+            if (_recent_chunks.size() > MAX_RECENT_CHUNKS)
+                _recent_chunks.pop_front();
+
+            return remainder;
+        }
+
+        CSV_INLINE void IStreamParser::next_chunk(std::istream& source, size_t bytes) {
+            if (this->eof()) return;
+
+            // Read the rest of the chunk from the stream directly after the carried over row
+            size_t length;
+            auto buffer = this->begin_chunk(length);
+
+            // Grow chunks geometrically while a row does not fit, so rows much
+            // longer than a chunk are copied a bounded number of times
+            bytes = std::max(bytes, length);
+            if (buffer->size() < length + bytes)
+                buffer->resize(length + bytes);
+
+            source.read(&(*buffer)[length], (std::streamsize)bytes);
+            length += (size_t)source.gcount();
+
+            if (source.bad())
+                throw std::runtime_error("Error while reading CSV stream");
+
+            this->parse_chunk(buffer, length, !source);
+        }
+
+        CSV_INLINE void FeedParser::feed(const char* data, size_t length) {
+            if (this->eof())
+                throw std::runtime_error("Cannot feed more data to a finished parser");
+
+            if (!_pending)
+                _pending = this->begin_chunk(_pending_length);
+
+            append_chunk(*_pending, _pending_length, data, length);
+
+            if (_pending_length >= _min_length) {
+                if (this->parse_chunk(_pending, _pending_length, false) == 0) {
+                    // No rows were completed, so nothing refers to _pending yet
+                    // and it can keep growing until it is worth parsing again
+                    _min_length = _pending_length * 2;
+                }
+                else {
+                    _pending = nullptr;
+                    _min_length = 0;
+                }
+            }
+        }
+
+        CSV_INLINE void FeedParser::finish() {
+            if (this->eof()) return;
+
+            if (!_pending)
+                _pending = this->begin_chunk(_pending_length);
+
+            this->parse_chunk(_pending, _pending_length, true);
+            _pending = nullptr;
+        }
+
+        CSV_INLINE void StringViewParser::next(size_t bytes) {
+            if (this->eof()) return;
+
+            const size_t length = std::max(bytes, _min_length);
+            csv::string_view data = _source.substr(_pos, length);
+            const bool last_chunk = _pos + data.size() == _source.size();
+
+            // Only a chunk which begins in the middle of a newline run (e.g. between
+            // the CR and LF of a CRLF) starts with a newline, and that run must not
+            // be mistaken for an empty row
+            size_t skipped = 0;
+            if (_pos > 0) {
+                while (skipped < data.size() && parse_flag(data[skipped]) == ParseFlags::NEWLINE)
+                    skipped++;
+            }
+
+            const size_t chunk_size = data.size();
+            data.remove_prefix(skipped);
+
+            this->reset_data_ptr();
+            this->data_ptr->_data = _owner;
+            this->data_ptr->data = data;
+
+            // Parse
+            this->current_row = CSVRow(this->data_ptr);
+            size_t remainder = skipped + this->parse();
+
+            if (last_chunk) {
+                this->_eof = true;
+                this->end_feed();
+            }
+            else {
+                // The next chunk must extend past the end of this one, and grows
+                // geometrically while a row does not fit
+                _pos += remainder;
+                _min_length = (chunk_size - remainder) * 2;
+                if (remainder < chunk_size)
+                    this->suspend_row();
+            }
+        }
+
+        CSV_INLINE FileMapping::FileMapping(const std::string& filename, size_t length, bool prefault) : _length(length) {
+            if (length == 0) return;
+
+#ifdef CSV_HAS_MADVISE
+            const int fd = ::open(filename.c_str(), O_RDONLY);
+            if (fd < 0) {
+                throw std::runtime_error("Cannot open file " + filename);
+            }
+
+            int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+            if (prefault) flags |= MAP_POPULATE;
+#endif
+            void* addr = ::mmap(nullptr, length, PROT_READ, flags, fd, 0);
+            ::close(fd);
+
+            if (addr == MAP_FAILED) {
+                throw std::runtime_error("Cannot memory map file " + filename);
+            }
+
+            this->_data = (const char*)addr;
+            ::madvise(addr, length, MADV_SEQUENTIAL);
+#else
+            (void)prefault;
             std::error_code error;
-            this->data_ptr->_data = std::make_shared<mio::basic_mmap_source<char>>(mio::make_mmap_source(this->_filename, this->mmap_pos, length, error));
-            this->mmap_pos += length;
+            this->_mmap = mio::make_mmap_source(filename, 0, length, error);
             if (error) throw error;
 
-            auto mmap_ptr = (mio::basic_mmap_source<char>*)(this->data_ptr->_data.get());
+            this->_data = this->_mmap.data();
+#endif
+        }
+
+        CSV_INLINE FileMapping::~FileMapping() {
+#ifdef CSV_HAS_MADVISE
+            if (this->_data) ::munmap((void*)this->_data, this->_length);
+#endif
+        }
+
+        CSV_INLINE size_t FileMapping::page_size() noexcept {
+#ifdef CSV_HAS_MADVISE
+            static const size_t size = (size_t)sysconf(_SC_PAGESIZE);
+            return size;
+#else
+            return 4096;
+#endif
+        }
+
+        CSV_INLINE void FileMapping::will_need(size_t begin, size_t end) noexcept {
+#ifdef CSV_HAS_MADVISE
+            const size_t page_size = FileMapping::page_size();
+            begin = begin / page_size * page_size;
+            end = std::min(end, this->_length);
+
+            if (begin < end)
+                ::madvise((void*)(this->_data + begin), end - begin, MADV_WILLNEED);
+#else
+            (void)begin;
+            (void)end;
+#endif
+        }
+
+        CSV_INLINE void FileMapping::dont_need(size_t begin, size_t end) noexcept {
+#ifdef CSV_HAS_MADVISE
+            // Pages shared with neighboring chunks are left alone
+            const size_t page_size = FileMapping::page_size();
+            begin = (begin + page_size - 1) / page_size * page_size;
+            end = end >= this->_length ? this->_length : end / page_size * page_size;
+
+            if (begin < end)
+                ::madvise((void*)(this->_data + begin), end - begin, MADV_DONTNEED);
+#else
+            (void)begin;
+            (void)end;
+#endif
+        }
+
+        CSV_INLINE std::shared_ptr<void> MmapParser::map_window(size_t pos, size_t length, csv::string_view& window) {
+            if (!this->_map_whole_file) {
+                std::error_code error;
+                auto mmap = std::make_shared<mio::basic_mmap_source<char>>(mio::make_mmap_source(this->_filename, pos, length, error));
+                if (error) {
+                    throw std::runtime_error("Cannot open file " + this->_filename);
+                }
+
+                window = csv::string_view(mmap->data(), mmap->length());
+                return mmap;
+            }
+
+            if (!this->_mapping) {
+                this->_mapping = std::make_shared<FileMapping>(this->_filename, this->source_size, this->_prefault);
+            }
+
+            // Have the kernel read in the next window while this one is parsed
+            this->_mapping->will_need(pos, pos + 2 * length);
+
+            auto chunk = std::make_shared<MappedChunk>();
+            chunk->mapping = this->_mapping;
+            chunk->begin = pos;
+            chunk->end = pos + length;
+
+            window = csv::string_view(this->_mapping->data() + pos, length);
+            return chunk;
+        }
+
+        CSV_INLINE void MmapParser::trim_window(const std::shared_ptr<void>& owner, size_t end) noexcept {
+            if (this->_map_whole_file)
+                static_cast<MappedChunk*>(owner.get())->end = end;
+        }
+
+        CSV_INLINE size_t MmapParser::skip_newline_run(size_t pos, csv::string_view& window) const noexcept {
+            // Windows other than the first always begin right after a newline
+            if (pos == 0) return 0;
+
+            size_t skipped = 0;
+            while (skipped < window.size() && parse_flag(window[skipped]) == ParseFlags::NEWLINE)
+                skipped++;
+
+            window.remove_prefix(skipped);
+            return skipped;
+        }
+
+        CSV_INLINE void MmapParser::next(size_t bytes = ITERATION_CHUNK_SIZE) {
+            // Rows can only be split across threads once the header has been seen
+            if (this->_parse_threads > 1 && this->_selection.ready())
+                this->next_parallel(bytes);
+            else
+                this->next_sequential(bytes);
+        }
+
+        CSV_INLINE void MmapParser::next_sequential(size_t bytes) {
+            this->reset_data_ptr();
+
+            // Create memory map
+            size_t length = std::min(this->source_size - this->mmap_pos, std::max(bytes, this->_min_length));
+            csv::string_view window;
+            this->data_ptr->_data = this->map_window(this->mmap_pos, length, window);
+            const size_t skipped = this->skip_newline_run(this->mmap_pos, window);
+            this->mmap_pos += length;
 
             // Create string view
-            this->data_ptr->data = csv::string_view(mmap_ptr->data(), mmap_ptr->length());
+            this->data_ptr->data = window;
 
             // Parse
             this->current_row = CSVRow(this->data_ptr);
-            size_t remainder = this->parse();            
+            size_t remainder = skipped + this->parse();
 
-            if (this->mmap_pos == this->source_size || no_chunk()) {
+            if (this->mmap_pos == this->source_size) {
                 this->_eof = true;
                 this->end_feed();
             }
 
             this->mmap_pos -= (length - remainder);
+            if (!this->_eof) {
+                this->trim_window(this->data_ptr->_data, this->mmap_pos);
+
+                // The next window begins with the partial row at the end of this one,
+                // and must extend past the end of this one
+                this->_min_length = (length - remainder) * 2;
+                if (remainder < length)
+                    this->suspend_row();
+            }
+        }
+
+        /** @par Implementation
+         *  The window is split into `_parse_threads` ranges of equal size, and parsed in two passes:
+         *   1. Every range counts its quote characters, and finds where its first row begins
+         *      assuming it starts both outside and inside of a quoted field. The parity of the
+         *      quote counts of the preceding ranges then tells us which guess was right.
+         *   2. Every range is parsed by its own RangeParser. Rows are pushed in file order once
+         *      all ranges are done.
+         *
+         *  If a range does not end exactly where the next one begins (which can only happen
+         *  with malformed quoting), the rest of the window is parsed sequentially instead.
+         */
+        CSV_INLINE void MmapParser::next_parallel(size_t bytes) {
+            const size_t n_ranges = this->_parse_threads;
+
+            // Windows are split into ranges from their beginning
+            this->discard_suspended_row();
+            bytes = std::max(bytes, this->_min_length);
+
+            // Create memory map
+            size_t window_pos = this->mmap_pos,
+                length = std::min(this->source_size - window_pos, bytes * n_ranges);
+            csv::string_view in;
+            auto window = this->map_window(window_pos, length, in);
+            const bool last_window = window_pos + length == this->source_size;
+
+            const size_t skipped = this->skip_newline_run(window_pos, in);
+            window_pos += skipped;
+            length -= skipped;
+
+            // Pass 1: Find out where each range's first row begins
+            std::vector<size_t> row_starts(n_ranges + 1, 0);
+            std::vector<std::array<size_t, 2>> candidates(n_ranges);
+            std::vector<char> odd_quotes(n_ranges, false);
+
+            run_parallel(*this->_executor, n_ranges, [&](size_t i) {
+                const size_t begin = length * i / n_ranges,
+                    end = length * (i + 1) / n_ranges;
+
+                if (this->_structural_chars.use_quote) {
+                    odd_quotes[i] = std::count(in.data() + begin, in.data() + end, this->_structural_chars.quote) % 2 == 1;
+                }
+
+                if (i > 0) {
+                    candidates[i][0] = find_row_start(in, begin, false, this->_structural_chars);
+                    candidates[i][1] = find_row_start(in, begin, true, this->_structural_chars);
+                }
+            });
+
+            bool quoted = false;
+            for (size_t i = 1; i < n_ranges; i++) {
+                quoted ^= (odd_quotes[i - 1] != 0);
+                row_starts[i] = std::max(candidates[i][quoted], row_starts[i - 1]);
+            }
+
+            row_starts[n_ranges] = length;
+
+            // Pass 2: Parse
+            std::vector<std::unique_ptr<RangeParser>> parsers(n_ranges);
+            std::vector<RowCollection> outputs(n_ranges);
+            std::vector<size_t> consumed(n_ranges, 0);
+
+            run_parallel(*this->_executor, n_ranges, [&](size_t i) {
+                parsers[i] = std::unique_ptr<RangeParser>(new RangeParser(
+                    this->_parse_flags, this->_ws_flags, this->_col_names,
+                    i == 0 && !this->unicode_bom_scan));
+                parsers[i]->set_output(outputs[i]);
+                parsers[i]->copy_dialect(*this);
+                parsers[i]->copy_selection(*this);
+                consumed[i] = parsers[i]->parse_range(window,
+                    in.substr(row_starts[i], row_starts[i + 1] - row_starts[i]));
+
+                // A BOM is consumed even if the row after it is not finished,
+                // so that parsing never resumes in front of it
+                if (i == 0 && parsers[i]->utf8_bom())
+                    consumed[i] = std::max(consumed[i], (size_t)3);
+            });
+
+            if (!this->unicode_bom_scan) {
+                this->_utf8_bom = parsers[0]->utf8_bom();
+                this->unicode_bom_scan = true;
+            }
+
+            // Push rows in file order
+            for (size_t i = 0; i < n_ranges; i++) {
+                const size_t range_length = row_starts[i + 1] - row_starts[i];
+                const bool last_range = (i + 1 == n_ranges);
+
+                if (last_range && last_window)
+                    parsers[i]->end_feed();
+
+                this->_rows_pushed += parsers[i]->rows_pushed();
+                this->_fields_pushed += parsers[i]->fields_pushed();
+                while (!outputs[i].empty())
+                    this->emit_row(outputs[i].pop_front());
+
+                if (!last_range && consumed[i] != range_length) {
+                    // Speculation failed: Fall back to parsing the rest of the window sequentially
+                    this->mmap_pos = window_pos + row_starts[i] + consumed[i];
+                    this->trim_window(window, this->mmap_pos);
+                    this->next_sequential(window_pos + length - this->mmap_pos);
+                    return;
+                }
+            }
+
+            this->mmap_pos = window_pos + row_starts[n_ranges - 1] + consumed[n_ranges - 1];
+            if (last_window) {
+                this->mmap_pos = this->source_size;
+                this->_eof = true;
+            }
+            else {
+                this->trim_window(window, this->mmap_pos);
+            }
         }
 #ifdef _MSC_VER
 #pragma endregion
@@ -6,8 +6,12 @@
 #include <algorithm>
 #include <array>
 #include <condition_variable>
+#include <cstring>
 #include <deque>
+#include <exception>
 #include <fstream>
+#include <functional>
+#include <limits>
 #include <memory>
 #include <mutex>
 #include <unordered_map>
@@ -20,6 +24,8 @@
 #include "common.hpp"
 #include "csv_format.hpp"
 #include "csv_row.hpp"
+#include "csv_row_queue.hpp"
+#include "csv_simd.hpp"
 
 namespace csv {
     namespace internals {
@@ -81,6 +87,7 @@ namespace csv {
 
         CSV_INLINE size_t get_file_size(csv::string_view filename);
 
+        /** Read the first 500KB of a CSV file, decompressing it if necessary */
         CSV_INLINE std::string get_csv_head(csv::string_view filename);
 
         /** Read the first 500KB of a CSV file */
@@ -179,7 +186,100 @@ namespace csv {
             std::deque<T> data;
         };
 
-        constexpr const int UNINITIALIZED_FIELD = -1;
+        constexpr const size_t UNINITIALIZED_FIELD = std::numeric_limits<size_t>::max();
+
+        /** Run `task(0)` through `task(n_tasks - 1)` concurrently on `executor`,
+         *  using the calling thread for `task(0)`
+         *
+         *  @throws The first exception thrown by a task, once every task has finished
+         */
+        void run_parallel(Executor& executor, size_t n_tasks, const std::function<void(size_t)>& task);
+
+        /** Return the position of the first row which begins at or after `pos`,
+         *  or `in.size()` if there is none
+         *
+         *  @param[in] quoted Whether or not `pos` lies inside of a quoted field
+         */
+        size_t find_row_start(csv::string_view in, size_t pos, bool quoted, const StructuralChars& chars) noexcept;
+
+        /** Return the positions of the columns selected by `format`, in ascending order
+         *
+         *  @param[in] col_names The names of every column in the CSV
+         *  @throws    std::runtime_error if a selected column does not exist
+         */
+        std::vector<size_t> resolve_columns(const std::vector<std::string>& col_names, const CSVFormat& format);
+
+        /** Keeps track of which rows and fields a parser should store when
+         *  columns are selected or rows are filtered
+         *
+         *  @see CSVFormat::select_columns(), CSVFormat::filter()
+         */
+        struct RowSelection {
+            /** Whether or not any columns were selected or filters added */
+            bool enabled = false;
+
+            /** Whether or not any columns were selected */
+            bool project = false;
+
+            /** Names of the selected columns, if they still need to be looked up in the header */
+            std::vector<std::string> names = {};
+
+            /** Positions of the selected columns in ascending order */
+            std::vector<size_t> columns = {};
+
+            /** Where the (i)th slot is true if column i should be stored */
+            std::vector<char> keep = {};
+
+            /** Predicates every row after the header must satisfy */
+            std::vector<RowFilter> filters = {};
+
+            /** Index of the header row or -1 if there is none */
+            int header = 0;
+
+            /** Number of columns in the CSV (0 if not known yet) */
+            size_t n_cols = 0;
+
+            /** Number of rows seen so far, counted up to and including the header */
+            size_t rows_seen = 0;
+
+            /** Number of fields in the current row, including those which were skipped */
+            size_t row_fields = 0;
+
+            VariableColumnPolicy policy = VariableColumnPolicy::IGNORE_ROW;
+
+            /** Whether or not fields are currently being skipped */
+            bool active() const noexcept { return !this->keep.empty(); }
+
+            /** Whether or not rows can be selected without knowing what came before them */
+            bool ready() const noexcept {
+                return !this->enabled ||
+                    ((this->active() || !this->project) && this->n_cols > 0 && (int)this->rows_seen > this->header);
+            }
+
+            /** Set the selected columns */
+            void set_columns(std::vector<size_t> selected) {
+                this->columns = selected;
+                this->keep.assign(selected.empty() ? 0 : selected.back() + 1, false);
+                for (auto i : selected)
+                    this->keep[i] = true;
+            }
+
+            /** Whether or not the current field should be stored */
+            bool keep_field() noexcept {
+                const size_t i = this->row_fields++;
+                return !this->active() || (i < this->keep.size() && this->keep[i]);
+            }
+
+            /** Whether or not the current field is skipped, without moving on to the next one */
+            bool skips_field() const noexcept {
+                return this->active() && (this->row_fields >= this->keep.size() || !this->keep[this->row_fields]);
+            }
+
+            /** Whether or not the current field and all fields after it in the row are skipped */
+            bool skips_rest_of_row() const noexcept {
+                return this->active() && this->row_fields >= this->keep.size();
+            }
+        };
     }
 
     /** Standard type for storing collection of rows */
@@ -197,7 +297,9 @@ namespace csv {
             IBasicCSVParser() = default;
             IBasicCSVParser(const CSVFormat&, const ColNamesPtr&);
             IBasicCSVParser(const ParseFlagMap& parse_flags, const WhitespaceMap& ws_flags
-            ) : _parse_flags(parse_flags), _ws_flags(ws_flags) {};
+            ) : _parse_flags(parse_flags), _ws_flags(ws_flags) {
+                this->set_special_chars();
+            };
 
             virtual ~IBasicCSVParser() {}
 
@@ -221,7 +323,46 @@ namespace csv {
             /** Whether or not this CSV has a UTF-8 byte order mark */
             CONSTEXPR bool utf8_bom() const { return this->_utf8_bom; }
 
-            void set_output(RowCollection& rows) { this->_records = &rows; }
+            void set_output(RowCollection& rows) {
+                this->_records = &rows;
+                this->_batches = nullptr;
+            }
+
+            /** Push rows to a queue read by another thread */
+            void set_output(RowBatchQueue& rows) {
+                this->_batches = &rows;
+                this->_records = nullptr;
+            }
+
+            /** How many rows have been pushed to the output so far */
+            CONSTEXPR size_t rows_pushed() const noexcept { return this->_rows_pushed; }
+
+            /** How many fields the rows pushed to the output so far have */
+            CONSTEXPR size_t fields_pushed() const noexcept { return this->_fields_pushed; }
+
+            /** Parse using a state machine specialized for a dialect known at compile time
+             *
+             *  @note The caller is responsible for ensuring this parser was constructed
+             *        with the same dialect and no whitespace trimming
+             */
+            template<char Delim, char Quote, bool UseQuote>
+            void use_static_dialect() noexcept {
+                using Dialect = StaticDialect<Delim, Quote, UseQuote>;
+                this->_parse_dialect = &IBasicCSVParser::parse_dialect<Dialect>;
+                this->_state_machine = &IBasicCSVParser::parse_state_machine<Dialect>;
+            }
+
+            /** Use the same parsing engines as `other` */
+            void copy_dialect(const IBasicCSVParser& other) noexcept {
+                this->_parse_dialect = other._parse_dialect;
+                this->_state_machine = other._state_machine;
+            }
+
+            /** Store the same rows and columns as `other` */
+            void copy_selection(const IBasicCSVParser& other) {
+                this->_selection = other._selection;
+                this->_selection.row_fields = 0;
+            }
 
         protected:
             /** @name Current Parser State */
@@ -230,11 +371,16 @@ namespace csv {
             RawCSVDataPtr data_ptr = nullptr;
             ColNamesPtr _col_names = nullptr;
             CSVFieldList* fields = nullptr;
-            int field_start = UNINITIALIZED_FIELD;
+            size_t field_start = UNINITIALIZED_FIELD;
             size_t field_length = 0;
 
             /** An array where the (i + 128)th slot gives the ParseFlags for ASCII character i */
             ParseFlagMap _parse_flags;
+
+            /** An array where the (i + 128)th slot determines whether ASCII character i should
+             *  be trimmed
+             */
+            WhitespaceMap _ws_flags;
             ///@}
 
             /** @name Current Stream/File State */
@@ -245,9 +391,6 @@ namespace csv {
             size_t source_size = 0;
             ///@}
 
-            /** Whether or not source needs to be read in chunks */
-            CONSTEXPR bool no_chunk() const { return this->source_size < ITERATION_CHUNK_SIZE; }
-
             /** Parse the current chunk of data *
              *
              *  @returns How many character were read that are part of complete rows
@@ -256,23 +399,181 @@ namespace csv {
 
             /** Create a new RawCSVDataPtr for a new chunk of data */
             void reset_data_ptr();
-        private:
-            /** An array where the (i + 128)th slot determines whether ASCII character i should
-             *  be trimmed
+
+            /** Save the state of the partial row at the end of the chunk just parsed,
+             *  so that the next call to parse() continues that row where it left off
+             *  instead of scanning it again from the beginning
+             *
+             *  @note The next chunk must begin with the partial row, i.e. at the
+             *        position the last call to parse() returned, and it must not
+             *        end before this one
              */
-            WhitespaceMap _ws_flags;
+            void suspend_row();
+
+            /** Forget about any row saved by suspend_row() */
+            void discard_suspended_row() noexcept { this->_suspended = false; }
+
+            /** Where complete rows should be pushed to (only one of these is set) */
+            RowCollection* _records = nullptr;
+            RowBatchQueue* _batches = nullptr;
+
+            /** Push a complete row to the output */
+            void emit_row(CSVRow&& row) {
+                if (this->_batches)
+                    this->_batches->push_back(std::move(row));
+                else
+                    this->_records->push_back(std::move(row));
+            }
+
+            /** @see rows_pushed(), fields_pushed() */
+            size_t _rows_pushed = 0;
+            size_t _fields_pushed = 0;
+
+            /** The delimiter and quote character of this dialect */
+            StructuralChars _structural_chars = {};
+
+            /** Which rows and columns should be stored */
+            RowSelection _selection;
+
+            /** Whether or not an attempt to find Unicode BOM has been made */
+            bool unicode_bom_scan = false;
+            bool _utf8_bom = false;
+
+        private:
+            /** Classifies characters by looking them up in _parse_flags and _ws_flags */
+            struct RuntimeDialect {
+                static CONSTEXPR_17 ParseFlags parse_flag(const IBasicCSVParser& parser, const char ch) noexcept {
+                    return parser.parse_flag(ch);
+                }
+
+                static CONSTEXPR_17 bool ws_flag(const IBasicCSVParser& parser, const char ch) noexcept {
+                    return parser.ws_flag(ch);
+                }
+
+                static bool use_bitmap_engine(const IBasicCSVParser& parser) noexcept {
+                    return parser._use_bitmap_engine;
+                }
+
+                static const StructuralChars& structural_chars(const IBasicCSVParser& parser) noexcept {
+                    return parser._structural_chars;
+                }
+
+                static const SpecialChars& special_chars(const IBasicCSVParser& parser) noexcept {
+                    return parser._special_chars;
+                }
+
+                static const SpecialChars& quote_chars(const IBasicCSVParser& parser) noexcept {
+                    return parser._quote_chars;
+                }
+
+                static const SpecialChars& separator_chars(const IBasicCSVParser& parser) noexcept {
+                    return parser._separator_chars;
+                }
+            };
+
+            /** Classifies characters with comparisons against compile-time constants */
+            template<char Delim, char Quote, bool UseQuote>
+            struct StaticDialect {
+                static constexpr ParseFlags parse_flag(const IBasicCSVParser&, const char ch) noexcept {
+                    return ch == Delim ? ParseFlags::DELIMITER
+                        : (ch == '\r' || ch == '\n') ? ParseFlags::NEWLINE
+                        : (UseQuote && ch == Quote) ? ParseFlags::QUOTE
+                        : ParseFlags::NOT_SPECIAL;
+                }
+
+                static constexpr bool ws_flag(const IBasicCSVParser&, const char) noexcept {
+                    return false;
+                }
+
+                /** Static dialects never trim whitespace, which is all the bitmap engine cannot handle */
+                static constexpr bool use_bitmap_engine(const IBasicCSVParser&) noexcept {
+                    return true;
+                }
+
+                static constexpr StructuralChars structural_chars(const IBasicCSVParser&) noexcept {
+                    return { Delim, Quote, UseQuote };
+                }
+
+                static constexpr SpecialChars special_chars(const IBasicCSVParser&) noexcept {
+                    return {{ Delim, '\r', '\n', UseQuote ? Quote : Delim }};
+                }
+
+                static constexpr SpecialChars quote_chars(const IBasicCSVParser&) noexcept {
+                    return {{ UseQuote ? Quote : Delim, UseQuote ? Quote : Delim,
+                        UseQuote ? Quote : Delim, UseQuote ? Quote : Delim }};
+                }
+
+                static constexpr SpecialChars separator_chars(const IBasicCSVParser&) noexcept {
+                    return {{ Delim, '\r', '\n', Delim }};
+                }
+            };
+
+            /** The engines used by parse(), i.e. parse_dialect() specialized on a dialect */
+            size_t (IBasicCSVParser::*_parse_dialect)() = &IBasicCSVParser::parse_dialect<RuntimeDialect>;
+
+            /** The state machine resume_row() finishes interrupted fields with */
+            size_t (IBasicCSVParser::*_state_machine)() = &IBasicCSVParser::parse_state_machine<RuntimeDialect>;
+
+            /** Characters which end a run of NOT_SPECIAL characters outside of quotes */
+            SpecialChars _special_chars = {};
+
+            /** Characters which end a run of NOT_SPECIAL characters inside of quotes */
+            SpecialChars _quote_chars = {};
+
+            /** Characters which end an unquoted field, i.e. the delimiter and newlines */
+            SpecialChars _separator_chars = {};
+
+            /** Fastest find_special() implementation supported by this CPU */
+            FindSpecialFunc _find_special = find_special_func();
+
+            /** @name Bitmap Parsing Engine State */
+            ///@{
+            /** Whether or not this dialect can be handled by parse_bitmap() and parse_quote_free() */
+            bool _use_bitmap_engine = false;
+
+            /** Fastest build_structural_index() implementation supported by this CPU */
+            StructuralIndexFunc _build_index = build_structural_index_func();
+
+            /** Bitmaps of unquoted delimiters and newlines for the current chunk */
+            std::vector<uint64_t> _separator_index;
+
+            /** Bitmaps of quote characters for the current chunk */
+            std::vector<uint64_t> _quote_index;
+            ///@}
+
             bool quote_escape = false;
             bool field_has_double_quote = false;
 
             /** Where we are in the current data block */
             size_t data_pos = 0;
 
-            /** Whether or not an attempt to find Unicode BOM has been made */
-            bool unicode_bom_scan = false;
-            bool _utf8_bom = false;
+            /** @name Suspended Row State
+             *  The partial row saved by suspend_row()
+             */
+            ///@{
+            bool _suspended = false;
 
-            /** Where complete rows should be pushed to */
-            RowCollection* _records = nullptr;
+            /** The fields of the row which were already complete */
+            std::vector<RawCSVField> _suspended_fields;
+
+            /** Where parsing should continue, relative to the beginning of the row */
+            size_t _suspended_pos = 0;
+
+            /** If true, the state machine returns as soon as the current field ends */
+            bool _finish_field_only = false;
+            ///@}
+
+            /** Whether or not parsing stopped in the middle of a field */
+            bool field_in_progress() const noexcept {
+                return this->field_start != UNINITIALIZED_FIELD || this->field_length > 0 || this->quote_escape;
+            }
+
+            /** Continue the row saved by suspend_row()
+             *
+             *  @returns False if the chunk ended before the field which was
+             *           interrupted by the end of the last chunk
+             */
+            bool resume_row();
 
             CONSTEXPR_17 bool ws_flag(const char ch) const noexcept {
                 return _ws_flags.data()[ch + 128];
@@ -282,83 +583,621 @@ namespace csv {
                 return this->current_row.data_start;
             }
 
+            /** Populate the character sets used by vectorized scans from _parse_flags */
+            void set_special_chars();
+
+            template<typename Dialect>
             void parse_field() noexcept;
 
+            /** Parse the rest of the current chunk with the fastest engines that can handle it
+             *
+             *  @tparam Dialect Either RuntimeDialect or a StaticDialect
+             *  @returns The number of characters parsed that belong to complete rows
+             */
+            template<typename Dialect>
+            size_t parse_dialect();
+
+            /** Parse the rest of the current chunk one character at a time
+             *
+             *  @tparam Dialect Either RuntimeDialect or a StaticDialect
+             *  @returns The number of characters parsed that belong to complete rows
+             */
+            template<typename Dialect>
+            size_t parse_state_machine();
+
+            /** Parse complete fields using a structural index of the current chunk
+             *
+             *  @returns The position where the state machine in parse() should take
+             *           over, which is always the beginning of a field
+             */
+            template<typename Dialect>
+            size_t parse_bitmap();
+
+            /** Parse complete rows of a chunk without any quote characters by searching
+             *  for newlines and then splitting each row on the delimiter
+             *
+             *  @returns The position where the state machine in parse() should take
+             *           over, which is always the beginning of a row
+             */
+            template<typename Dialect>
+            size_t parse_quote_free();
+
+            /** Push a field found by parse_bitmap()
+             *
+             *  @param[in] begin Position of the field's first character
+             *  @param[in] end   Position of the separator following the field
+             *  @returns False if the field is not of a form that parse_bitmap() can handle,
+             *           e.g. it contains quotes but is not quoted
+             */
+            template<typename Dialect>
+            bool push_bitmap_field(size_t begin, size_t end);
+
             /** Finish parsing the current field */
             void push_field();
 
             /** Finish parsing the current row */
             void push_row();
 
+            /** Apply column selection and row filters to the current row, which has just ended
+             *
+             *  @returns False if the row should be dropped
+             *  @throws  std::runtime_error if a selected column does not exist, or if
+             *           the row has the wrong number of fields and the variable column
+             *           policy is THROW. Exceptions thrown by filters are passed on.
+             */
+            bool select_row();
+
             /** Handle possible Unicode byte order mark */
             void trim_utf8_bom();
         };
 
+        template<typename Dialect>
+        inline void IBasicCSVParser::parse_field() noexcept {
+            using internals::ParseFlags;
+            auto& in = this->data_ptr->data;
+
+            // Trim off leading whitespace
+            while (data_pos < in.size() && Dialect::ws_flag(*this, in[data_pos]))
+                data_pos++;
+
+            if (field_start == UNINITIALIZED_FIELD)
+                field_start = data_pos - current_row_start();
+
+            // Columns which were not selected are only scanned for the delimiter or
+            // newline ending them, unless they are quoted. Quotes after the first
+            // character of an unquoted field are not special.
+            const bool skip = !this->quote_escape && this->_selection.skips_field()
+                && (this->field_length > 0 || data_pos == in.size()
+                    || Dialect::parse_flag(*this, in[data_pos]) != ParseFlags::QUOTE);
+
+            // Optimization: Since NOT_SPECIAL characters tend to occur in contiguous
+            // sequences, skip over them in bulk (16-64 bytes at a time when SIMD is
+            // available) to avoid having to go through the outer switch statement
+            // as much as possible
+            const char* end = this->_find_special(
+                in.data() + data_pos, in.data() + in.size(),
+                this->quote_escape ? Dialect::quote_chars(*this)
+                : skip ? Dialect::separator_chars(*this)
+                : Dialect::special_chars(*this));
+            data_pos = (size_t)(end - in.data());
+
+            field_length = data_pos - (field_start + current_row_start());
+            if (skip) return;
+
+            // Trim off trailing whitespace, this->field_length constraint matters
+            // when field is entirely whitespace
+            for (size_t j = data_pos - 1; Dialect::ws_flag(*this, in[j]) && this->field_length > 0; j--)
+                this->field_length--;
+        }
+
+        template<typename Dialect>
+        inline size_t IBasicCSVParser::parse_dialect() {
+            // The bitmap engine consumes as many complete fields as it can, leaving
+            // the state machine below to handle the last partial row and anything
+            // the engine does not understand. Chunks without any quote characters
+            // can skip quote tracking altogether.
+            if (Dialect::use_bitmap_engine(*this)) {
+                auto& in = this->data_ptr->data;
+                const StructuralChars& chars = Dialect::structural_chars(*this);
+                const bool quote_free = !chars.use_quote || !std::memchr(
+                    in.data() + this->data_pos, chars.quote, in.size() - this->data_pos);
+
+                this->data_pos = quote_free ? this->parse_quote_free<Dialect>() : this->parse_bitmap<Dialect>();
+            }
+
+            return this->parse_state_machine<Dialect>();
+        }
+
+        template<typename Dialect>
+        inline size_t IBasicCSVParser::parse_state_machine() {
+            using internals::ParseFlags;
+
+            auto& in = this->data_ptr->data;
+            while (this->data_pos < in.size()) {
+                switch (quote_escape_flag(Dialect::parse_flag(*this, in[this->data_pos]), this->quote_escape)) {
+                case ParseFlags::DELIMITER:
+                    this->push_field();
+                    this->data_pos++;
+
+                    if (this->_finish_field_only) {
+                        this->_finish_field_only = false;
+                        return this->current_row_start();
+                    }
+
+                    break;
+
+                case ParseFlags::NEWLINE:
+                    this->data_pos++;
+
+                    // Catches CRLF (or LFLF, CRCRLF, or any other non-sensical combination of newlines)
+                    while (this->data_pos < in.size() && Dialect::parse_flag(*this, in[this->data_pos]) == ParseFlags::NEWLINE)
+                        this->data_pos++;
+
+                    // End of record -> Write record
+                    this->push_field();
+                    this->push_row();
+
+                    // Reset
+                    this->current_row = CSVRow(data_ptr, this->data_pos, fields->size());
+
+                    if (this->_finish_field_only) {
+                        this->_finish_field_only = false;
+                        return this->current_row_start();
+                    }
+
+                    break;
+
+                case ParseFlags::NOT_SPECIAL:
+                    this->parse_field<Dialect>();
+                    break;
+
+                case ParseFlags::QUOTE_ESCAPE_QUOTE:
+                    if (data_pos + 1 == in.size()) return this->current_row_start();
+                    else if (data_pos + 1 < in.size()) {
+                        auto next_ch = Dialect::parse_flag(*this, in[data_pos + 1]);
+                        if (next_ch >= ParseFlags::DELIMITER) {
+                            quote_escape = false;
+                            data_pos++;
+                            break;
+                        }
+                        else if (next_ch == ParseFlags::QUOTE) {
+                            // Case: Escaped quote
+                            data_pos += 2;
+                            this->field_length += 2;
+                            this->field_has_double_quote = true;
+                            break;
+                        }
+                    }
+                    
+                    // Case: Unescaped single quote => not strictly valid but we'll keep it
+                    this->field_length++;
+                    data_pos++;
+
+                    break;
+
+                default: // Quote (currently not quote escaped)
+                    if (this->field_length == 0) {
+                        quote_escape = true;
+                        data_pos++;
+                        if (field_start == UNINITIALIZED_FIELD && data_pos < in.size() && !Dialect::ws_flag(*this, in[data_pos]))
+                            field_start = data_pos - current_row_start();
+                        break;
+                    }
+
+                    // Case: Unescaped quote
+                    this->field_length++;
+                    data_pos++;
+
+                    break;
+                }
+            }
+
+            return this->current_row_start();
+        }
+
+        template<typename Dialect>
+        inline size_t IBasicCSVParser::parse_bitmap() {
+            using internals::ParseFlags;
+
+            // Stage one: Build bitmaps of quotes and unquoted separators
+            auto& in = this->data_ptr->data;
+            const size_t start = this->data_pos,
+                length = in.size() - start,
+                n_words = index_words(length);
+
+            _separator_index.resize(n_words);
+            _quote_index.resize(n_words);
+            _build_index(in.data() + start, length, Dialect::structural_chars(*this),
+                _separator_index.data(), _quote_index.data(), false);
+
+            // Stage two: Walk the separators, pushing fields and rows
+            const char* base = in.data() + start;
+            size_t pos = 0,
+                sep = next_set_bit(_separator_index.data(), n_words, 0);
+
+            while (sep < length) {
+                if (!this->push_bitmap_field<Dialect>(pos, sep))
+                    break;
+
+                pos = sep + 1;
+
+                if (Dialect::parse_flag(*this, base[sep]) == ParseFlags::NEWLINE) {
+                    this->push_row();
+
+                    // Catches CRLF (or LFLF, CRCRLF, or any other non-sensical combination of newlines)
+                    while (pos < length && Dialect::parse_flag(*this, base[pos]) == ParseFlags::NEWLINE)
+                        pos++;
+
+                    this->current_row = CSVRow(data_ptr, start + pos, fields->size());
+                }
+
+                sep = next_set_bit(_separator_index.data(), n_words, pos);
+            }
+
+            return start + pos;
+        }
+
+        template<typename Dialect>
+        inline size_t IBasicCSVParser::parse_quote_free() {
+            auto& in = this->data_ptr->data;
+            const char* const begin = in.data(),
+                * const end = begin + in.size();
+            const char delim = Dialect::structural_chars(*this).delim;
+            const SpecialChars newlines = { '\r', '\n', '\r', '\n' };
+
+            const char* row = begin + this->data_pos;
+            const char* row_end;
+            while ((row_end = this->_find_special(row, end, newlines)) != end) {
+                const char* const row_start = begin + current_row_start();
+
+                // Split the row on the delimiter
+                for (const char* field = row;;) {
+                    // Fields after the last selected column only need to be counted
+                    if (this->_selection.skips_rest_of_row()) {
+                        this->_selection.row_fields += 1 + (size_t)std::count(field, row_end, delim);
+                        break;
+                    }
+
+                    const char* field_end = (const char*)std::memchr(field, delim, (size_t)(row_end - field));
+                    if (!field_end) field_end = row_end;
+
+                    this->field_length = (size_t)(field_end - field);
+                    if (this->field_length > 0)
+                        this->field_start = (size_t)(field - row_start);
+
+                    this->push_field();
+
+                    if (field_end == row_end) break;
+                    field = field_end + 1;
+                }
+
+                this->push_row();
+
+                // Catches CRLF (or LFLF, CRCRLF, or any other non-sensical combination of newlines)
+                row = row_end + 1;
+                while (row < end && (*row == '\r' || *row == '\n'))
+                    row++;
+
+                this->current_row = CSVRow(data_ptr, (size_t)(row - begin), fields->size());
+            }
+
+            return (size_t)(row - begin);
+        }
+
+        template<typename Dialect>
+        inline bool IBasicCSVParser::push_bitmap_field(size_t begin, size_t end) {
+            // Only search the words which overlap with this field
+            const size_t n_words = index_words(end),
+                offset = this->data_pos - current_row_start();
+            const char* base = this->data_ptr->data.data() + this->data_pos;
+            const char quote = Dialect::structural_chars(*this).quote;
+
+            size_t quote_pos = next_set_bit(_quote_index.data(), n_words, begin);
+            if (quote_pos >= end) {
+                // Unquoted field
+                this->field_length = end - begin;
+                if (this->field_length > 0)
+                    this->field_start = offset + begin;
+            }
+            else if (quote_pos == begin && end - begin >= 2 && base[end - 1] == quote) {
+                // Quoted field: Every quote between the opening and closing quotes
+                // must be part of an escaped quote
+                size_t i = begin + 1;
+                while ((quote_pos = next_set_bit(_quote_index.data(), n_words, i)) < end - 1) {
+                    if (quote_pos + 1 < end - 1 && base[quote_pos + 1] == quote) {
+                        this->field_has_double_quote = true;
+                        i = quote_pos + 2;
+                    }
+                    else {
+                        this->field_has_double_quote = false;
+                        return false;
+                    }
+                }
+
+                this->field_start = offset + begin + 1;
+                this->field_length = end - begin - 2;
+            }
+            else {
+                return false;
+            }
+
+            this->push_field();
+            return true;
+        }
+
+        /** Functionality shared by parsers which receive their input in pieces,
+         *  from a `std::istream` or from FeedParser::feed()
+         *
+         *  @par Implementation
+         *  Input is stored in the buffer owned by a chunk's RawCSVData, after a copy
+         *  of the partial row at the end of the previous chunk. Buffers of recent
+         *  chunks are recycled once no CSVRow refers to them anymore. Only the first
+         *  `length` characters of a buffer are used, so recycled buffers keep their
+         *  size and are not cleared or zero-filled again.
+         */
+        class IStreamParser : public IBasicCSVParser {
+        public:
+            IStreamParser(const CSVFormat& format, const ColNamesPtr& col_names)
+                : IBasicCSVParser(format, col_names) {};
+
+            IStreamParser(const ParseFlagMap& parse_flags, const WhitespaceMap& ws_flags)
+                : IBasicCSVParser(parse_flags, ws_flags) {};
+
+            /** How many chunks were parsed in a buffer reused from an earlier chunk */
+            size_t recycled_chunks() const { return _recycled_chunks; }
+
+        protected:
+            /** Read up to `bytes` more characters from `source` and parse them */
+            void next_chunk(std::istream& source, size_t bytes);
+
+            /** Return an unused buffer which begins with the partial row
+             *  at the end of the previous chunk
+             *
+             *  @param[out] length How many characters of the buffer are in use
+             */
+            std::shared_ptr<std::string> begin_chunk(size_t& length);
+
+            /** Copy `n` characters to `buffer` after its first `length`, growing it if needed */
+            static void append_chunk(std::string& buffer, size_t& length, const char* data, size_t n);
+
+            /** Parse the first `length` characters of a buffer returned by begin_chunk()
+             *
+             *  @param[in] last Whether or not this is the end of the input
+             *  @returns   How many characters belong to complete rows
+             */
+            size_t parse_chunk(const std::shared_ptr<std::string>& buffer, size_t length, bool last) {
+                return this->parse_chunk(buffer, csv::string_view(buffer->data(), length), last);
+            }
+
+            /** Parse `data`, which lies in `buffer` and begins with a copy of carry()
+             *
+             *  @see parse_chunk(const std::shared_ptr<std::string>&, size_t, bool)
+             */
+            size_t parse_chunk(const std::shared_ptr<std::string>& buffer, csv::string_view data, bool last);
+
+            /** Unparsed characters at the end of the previous chunk, which the next chunk has to begin with */
+            csv::string_view carry() const noexcept { return _carry; }
+
+        private:
+            /** How many recently parsed chunks to consider for recycling */
+            static constexpr size_t MAX_RECENT_CHUNKS = 2;
+
+            /** Recently parsed chunks, whose buffers may be reused */
+            std::deque<RawCSVDataPtr> _recent_chunks;
+
+            /** Unparsed characters at the end of the previous chunk */
+            csv::string_view _carry = "";
+
+            /** Whether or not the previous chunk ended with a complete row, so
+             *  newlines at the start of the next one should be skipped
+             */
+            bool _skip_newlines = false;
+
+            /** @see recycled_chunks() */
+            size_t _recycled_chunks = 0;
+        };
+
         /** A class for parsing CSV data from a `std::stringstream`
          *  or an `std::ifstream`
          */
         template<typename TStream>
-        class StreamParser: public IBasicCSVParser {
+        class StreamParser: public IStreamParser {
             using RowCollection = ThreadSafeDeque<CSVRow>;
 
         public:
             StreamParser(TStream& source,
                 const CSVFormat& format,
                 const ColNamesPtr& col_names = nullptr
-            ) : IBasicCSVParser(format, col_names), _source(std::move(source)) {};
+            ) : IStreamParser(format, col_names), _source(std::move(source)) {};
 
             StreamParser(
                 TStream& source,
                 internals::ParseFlagMap parse_flags,
                 internals::WhitespaceMap ws_flags) :
-                IBasicCSVParser(parse_flags, ws_flags),
+                IStreamParser(parse_flags, ws_flags),
                 _source(std::move(source))
             {};
 
             ~StreamParser() {}
 
             void next(size_t bytes = ITERATION_CHUNK_SIZE) override {
-                if (this->eof()) return;
+                this->next_chunk(_source, bytes);
+            }
 
-                this->reset_data_ptr();
-                this->data_ptr->_data = std::make_shared<std::string>();
+        private:
+            TStream _source;
+        };
 
-                if (source_size == 0) {
-                    const auto start = _source.tellg();
-                    _source.seekg(0, std::ios::end);
-                    const auto end = _source.tellg();
-                    _source.seekg(0, std::ios::beg);
+        /** A class for parsing streams which cannot be moved, such as `std::cin`
+         *
+         *  @note The stream must outlive this parser
+         */
+        class ForwardStreamParser : public IStreamParser {
+        public:
+            ForwardStreamParser(std::istream& source,
+                const CSVFormat& format,
+                const ColNamesPtr& col_names = nullptr
+            ) : IStreamParser(format, col_names), _source(source) {};
 
-                    source_size = end - start;
-                }
+            ~ForwardStreamParser() {}
 
-                // Read data into buffer
-                size_t length = std::min(source_size - stream_pos, bytes);
-                std::unique_ptr<char[]> buff(new char[length]);
-                _source.seekg(stream_pos, std::ios::beg);
-                _source.read(buff.get(), length);
-                stream_pos = _source.tellg();
-                ((std::string*)(this->data_ptr->_data.get()))->assign(buff.get(), length);
+            void next(size_t bytes = ITERATION_CHUNK_SIZE) override {
+                this->next_chunk(_source, bytes);
+            }
 
-                // Create string_view
-                this->data_ptr->data = *((std::string*)this->data_ptr->_data.get());
+        private:
+            std::istream& _source;
+        };
 
-                // Parse
-                this->current_row = CSVRow(this->data_ptr);
-                size_t remainder = this->parse();
+        /** A class for parsing CSV data which is pushed to it in pieces of any size
+         *
+         *  @note Parsing only happens once enough data has arrived to complete a row,
+         *        so rows spanning many pieces are not parsed over and over
+         */
+        class FeedParser : public IStreamParser {
+        public:
+            FeedParser(const CSVFormat& format, const ColNamesPtr& col_names = nullptr)
+                : IStreamParser(format, col_names) {};
 
-                if (stream_pos == source_size || no_chunk()) {
-                    this->_eof = true;
-                    this->end_feed();
-                }
-                else {
-                    this->stream_pos -= (length - remainder);
-                }
+            ~FeedParser() {}
+
+            /** Not used: Input is passed to feed() */
+            void next(size_t) override {}
+
+            /** Parse as many complete rows as possible after appending `length` characters */
+            void feed(const char* data, size_t length);
+
+            /** Parse whatever is left over as the last row */
+            void finish();
+
+        private:
+            /** Data which has not been parsed into complete rows yet */
+            std::shared_ptr<std::string> _pending = nullptr;
+
+            /** How many characters of _pending are in use */
+            size_t _pending_length = 0;
+
+            /** How large _pending must be before it is parsed again */
+            size_t _min_length = 0;
+        };
+
+        /** A class for parsing CSV data which is already in memory, without copying it
+         *
+         *  @note Unless an owner is given, the caller must ensure the data outlives every
+         *        CSVRow created from it
+         */
+        class StringViewParser : public IBasicCSVParser {
+        public:
+            StringViewParser(csv::string_view source,
+                const CSVFormat& format,
+                const ColNamesPtr& col_names = nullptr,
+                std::shared_ptr<void> owner = nullptr
+            ) : IBasicCSVParser(format, col_names), _source(source), _owner(std::move(owner)) {};
+
+            ~StringViewParser() {}
+
+            void next(size_t bytes = ITERATION_CHUNK_SIZE) override;
+
+        private:
+            csv::string_view _source;
+
+            /** Keeps the memory `_source` points into alive, if not null */
+            std::shared_ptr<void> _owner;
+
+            /** Where the next chunk begins */
+            size_t _pos = 0;
+
+            /** Minimum size of the next chunk, which grows when a
+             *  row does not fit into a chunk of the requested size
+             */
+            size_t _min_length = 0;
+        };
+
+        /** Parses one byte range of a memory mapped window on behalf of MmapParser
+         *
+         *  @see MmapParser::next_parallel()
+         */
+        class RangeParser : public IBasicCSVParser {
+        public:
+            RangeParser(
+                const ParseFlagMap& parse_flags,
+                const WhitespaceMap& ws_flags,
+                const ColNamesPtr& col_names,
+                bool scan_utf8_bom
+            ) : IBasicCSVParser(parse_flags, ws_flags) {
+                this->_col_names = col_names;
+                this->unicode_bom_scan = !scan_utf8_bom;
             }
 
+            /** Not used: see parse_range() */
+            void next(size_t) override {}
+
+            /** Parse the rows in `range`
+             *
+             *  @param[in] source Keeps the memory `range` points into alive
+             *  @returns   How many characters were read that are part of complete rows
+             */
+            size_t parse_range(const std::shared_ptr<void>& source, csv::string_view range) {
+                this->reset_data_ptr();
+                this->data_ptr->_data = source;
+                this->data_ptr->data = range;
+                this->current_row = CSVRow(this->data_ptr);
+                return this->parse();
+            }
+        };
+
+        /** A read-only memory map of an entire file
+         *
+         *  @note The kernel is only given read-ahead and release hints on POSIX
+         *        systems. Elsewhere, will_need() and dont_need() do nothing.
+         */
+        class FileMapping {
+        public:
+            /** Map the first `length` bytes of a file
+             *
+             *  @param[in] prefault Read the whole file in now, if supported
+             */
+            FileMapping(const std::string& filename, size_t length, bool prefault);
+            ~FileMapping();
+
+            FileMapping(const FileMapping&) = delete;
+            FileMapping& operator=(const FileMapping&) = delete;
+
+            const char* data() const noexcept { return this->_data; }
+            size_t size() const noexcept { return this->_length; }
+
+            /** Ask the kernel to start reading in the bytes in [begin, end) */
+            void will_need(size_t begin, size_t end) noexcept;
+
+            /** Allow the kernel to drop the pages lying entirely in [begin, end)
+             *
+             *  @note Dropped pages are read back in from the file if they are touched again
+             */
+            void dont_need(size_t begin, size_t end) noexcept;
+
         private:
-            TStream _source;
-            size_t stream_pos = 0;
+            const char* _data = nullptr;
+            size_t _length = 0;
+
+            /** The mapping itself on systems where it is not created with mmap() directly */
+            mio::basic_mmap_source<char> _mmap;
+
+            /** The size of a memory page, which is only looked up once */
+            static size_t page_size() noexcept;
+        };
+
+        /** One chunk of a FileMapping, which releases its pages once
+         *  no rows refer to it anymore
+         */
+        struct MappedChunk {
+            std::shared_ptr<FileMapping> mapping;
+
+            /** The part of the file rows from this chunk may point into */
+            size_t begin = 0, end = 0;
+
+            ~MappedChunk() {
+                mapping->dont_need(begin, end);
+            }
         };
 
         /** Parser for memory-mapped files
@@ -369,6 +1208,8 @@ namespace csv {
          *  than the user has available. It contains logic to automatically
          *  re-align each memory map to the beginning of a CSV row.
          *
+         *  If CSVFormat::map_whole_file() is set, the file is mapped once and
+         *  each window is a view into that mapping instead.
          */
         class MmapParser : public IBasicCSVParser {
         public:
@@ -378,6 +1219,10 @@ namespace csv {
             ) : IBasicCSVParser(format, col_names) {
                 this->_filename = filename.data();
                 this->source_size = get_file_size(filename);
+                this->_parse_threads = format.get_parse_threads();
+                this->_executor = &format.get_executor();
+                this->_map_whole_file = format.get_map_whole_file();
+                this->_prefault = format.get_prefault_mapping();
             };
 
             ~MmapParser() {}
@@ -387,6 +1232,50 @@ namespace csv {
         private:
             std::string _filename;
             size_t mmap_pos = 0;
+
+            /** Number of ranges each window is split into */
+            size_t _parse_threads = 1;
+
+            /** Runs the tasks parsing those ranges */
+            Executor* _executor = nullptr;
+
+            bool _map_whole_file = false;
+            bool _prefault = false;
+
+            /** Minimum size of the next window, which grows when a
+             *  row does not fit into a window of the requested size
+             */
+            size_t _min_length = 0;
+
+            /** Created by the first call to map_window() if _map_whole_file is set */
+            std::shared_ptr<FileMapping> _mapping = nullptr;
+
+            /** Map `length` bytes of the file starting at `pos`
+             *
+             *  @param[out] window The mapped bytes
+             *  @returns    An object which keeps `window` alive
+             */
+            std::shared_ptr<void> map_window(size_t pos, size_t length, csv::string_view& window);
+
+            /** Record that rows from a window returned by map_window() only
+             *  point into the file before `end`
+             */
+            void trim_window(const std::shared_ptr<void>& owner, size_t end) noexcept;
+
+            /** Remove the rest of a newline run split by the previous window
+             *  (e.g. the LF of a CRLF) from the start of a window beginning at `pos`
+             *
+             *  @returns How many characters were removed
+             */
+            size_t skip_newline_run(size_t pos, csv::string_view& window) const noexcept;
+
+            /** Map a window `bytes` long and parse it on the calling thread */
+            void next_sequential(size_t bytes);
+
+            /** Map a window `bytes * _parse_threads` long and parse it in
+             *  `_parse_threads` ranges concurrently
+             */
+            void next_parallel(size_t bytes);
         };
     }
 }
@@ -50,6 +50,9 @@ namespace csv {
      *  @def CONSTEXPR
      *  Expands to `constexpr` in decent compilers and `inline` otherwise.
      *  Intended for functions and methods.
+     *
+     *  @def CSV_HAS_COROUTINES
+     *  Defined if C++20 coroutines are available, which enables CSVReader::next_batch()
      */
 
 #define STATIC_ASSERT(x) static_assert(x, "Assertion failed")
@@ -62,6 +65,10 @@ namespace csv {
 #define CSV_HAS_CXX14
 #endif
 
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L && __cplusplus >= 202002L
+#define CSV_HAS_COROUTINES
+#endif
+
 #ifdef CSV_HAS_CXX17
 #include <string_view>
      /** @typedef string_view
@@ -150,6 +157,9 @@ namespace csv {
          */
         constexpr size_t ITERATION_CHUNK_SIZE = 10000000; // 10MB
 
+        /** How many bytes from the start of a CSV are used to guess its format */
+        constexpr size_t GUESS_HEAD_SIZE = 500000;
+
         template<typename T>
         inline bool is_equal(T a, T b, T epsilon = 0.001) {
             /** Returns true if two floating point values are about the same */
@@ -0,0 +1,66 @@
+/** @file
+ *  @brief Decides how many bytes CSVReader parses at a time
+ */
+
+#include <algorithm>
+
+#include "csv_chunk_size.hpp"
+#include "csv_row.hpp"
+
+namespace csv {
+    namespace internals {
+        CSV_INLINE ChunkSizer::ChunkSizer(const CSVFormat& format) :
+            _size(format.get_chunk_size()),
+            _adaptive(format.get_adaptive_chunking()),
+            _memory_limit(format.get_chunk_memory_limit()),
+            _min_size(format.get_min_chunk_size()),
+            _max_size(format.get_max_chunk_size()) {
+            this->clamp();
+        }
+
+        CSV_INLINE ChunkSizer::ChunkSizer(const ChunkSizer& other) {
+            *this = other;
+        }
+
+        CSV_INLINE ChunkSizer& ChunkSizer::operator=(const ChunkSizer& other) {
+            this->_size.store(other.size(), std::memory_order_relaxed);
+            this->_adaptive = other._adaptive;
+            this->_memory_limit = other._memory_limit;
+            this->_min_size = other._min_size;
+            this->_max_size = other._max_size;
+            this->_chunks_in_flight = other._chunks_in_flight;
+            this->_footprint = other._footprint;
+            return *this;
+        }
+
+        CSV_INLINE void ChunkSizer::set_chunks_in_flight(size_t n_chunks) {
+            this->_chunks_in_flight = n_chunks ? n_chunks : 1;
+            this->clamp();
+        }
+
+        CSV_INLINE void ChunkSizer::update(size_t bytes, size_t rows, size_t fields, bool kept_up) noexcept {
+            if (!this->_adaptive || bytes == 0) return;
+
+            const size_t footprint = bytes + rows * sizeof(CSVRow) + fields * sizeof(RawCSVField);
+            this->_footprint = (double)footprint / (double)bytes;
+
+            if (kept_up && rows > 0 && bytes / rows <= SMALL_ROW_SIZE)
+                this->_size.store(this->size() * 2, std::memory_order_relaxed);
+
+            this->clamp();
+        }
+
+        CSV_INLINE void ChunkSizer::clamp() noexcept {
+            if (!this->_adaptive) return;
+
+            size_t size = std::min(std::max(this->size(), this->_min_size), this->_max_size);
+            if (this->_memory_limit) {
+                const double budget = (double)this->_memory_limit / (this->_footprint * (double)this->_chunks_in_flight);
+                size = std::min(size, (size_t)budget);
+            }
+
+            // The memory limit is not allowed to push chunks below the minimum size
+            this->_size.store(std::max(size, this->_min_size), std::memory_order_relaxed);
+        }
+    }
+}
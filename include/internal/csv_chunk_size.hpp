@@ -0,0 +1,71 @@
+/** @file
+ *  @brief Decides how many bytes CSVReader parses at a time
+ */
+
+#pragma once
+
+#include <atomic>
+
+#include "common.hpp"
+#include "csv_format.hpp"
+
+namespace csv {
+    namespace internals {
+        /** Chooses the chunk size of a CSVReader
+         *
+         *  With a fixed chunk size, this just returns CSVFormat::get_chunk_size().
+         *  In adaptive mode, the size is revised after every chunk:
+         *  - It doubles while rows are small and the consumer keeps up with the parser,
+         *    so per-chunk costs are spread over more rows
+         *  - It is capped so that the rows of every chunk which may be held at once,
+         *    including their field indices, fit in the memory limit
+         *
+         *  @see CSVFormat::adaptive_chunk_size()
+         */
+        class ChunkSizer {
+        public:
+            ChunkSizer() = default;
+            ChunkSizer(const CSVFormat& format);
+            ChunkSizer(const ChunkSizer& other);
+            ChunkSizer& operator=(const ChunkSizer& other);
+
+            /** Number of bytes the next chunk should have
+             *
+             *  @note May be called while another thread calls update()
+             */
+            size_t size() const noexcept { return this->_size.load(std::memory_order_relaxed); }
+
+            /** Set how many chunks may be held in memory at once */
+            void set_chunks_in_flight(size_t n_chunks);
+
+            /** Revise the chunk size after a chunk was parsed
+             *
+             *  @param[in] bytes    Size of the chunk
+             *  @param[in] rows     How many rows it contained
+             *  @param[in] fields   How many fields those rows contained
+             *  @param[in] kept_up  Whether the consumer had read the rows of earlier chunks by the time it was parsed
+             */
+            void update(size_t bytes, size_t rows, size_t fields, bool kept_up) noexcept;
+
+        private:
+            /** Rows longer than this are not considered small */
+            static constexpr size_t SMALL_ROW_SIZE = 1024;
+
+            /** Bytes of memory used per byte of CSV, assumed until a chunk was measured */
+            static constexpr double DEFAULT_FOOTPRINT = 4;
+
+            std::atomic<size_t> _size{ ITERATION_CHUNK_SIZE };
+            bool _adaptive = false;
+            size_t _memory_limit = 0;
+            size_t _min_size = 0;
+            size_t _max_size = 0;
+            size_t _chunks_in_flight = 2;
+
+            /** Bytes of memory used per byte of CSV by the last chunk */
+            double _footprint = DEFAULT_FOOTPRINT;
+
+            /** Clamp the chunk size to the configured bounds and the memory limit */
+            void clamp() noexcept;
+        };
+    }
+}
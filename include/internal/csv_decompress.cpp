@@ -0,0 +1,190 @@
+/** @file
+ *  @brief Support for reading compressed CSV files
+ */
+
+#include <vector>
+
+#include "csv_decompress.hpp"
+
+#ifdef CSV_HAS_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef CSV_HAS_ZSTD
+#include <zstd.h>
+#endif
+
+namespace csv {
+    namespace internals {
+        CSV_INLINE Compression detect_compression(csv::string_view filename) {
+            std::ifstream infile(std::string(filename), std::ios::binary);
+            unsigned char magic[4] = { 0, 0, 0, 0 };
+            infile.read((char*)magic, sizeof(magic));
+
+            if (infile.gcount() >= 2 && magic[0] == 0x1F && magic[1] == 0x8B)
+                return Compression::GZIP;
+
+            if (infile.gcount() == 4 && magic[0] == 0x28 && magic[1] == 0xB5 && magic[2] == 0x2F && magic[3] == 0xFD)
+                return Compression::ZSTD;
+
+            return Compression::NONE;
+        }
+
+        /** Size of the reads of compressed data done by decompressors */
+        constexpr size_t COMPRESSED_READ_SIZE = 1 << 16;
+
+#ifdef CSV_HAS_ZLIB
+        /** Decompresses gzip files, including ones made of several concatenated members */
+        class GzipDecompressor : public Decompressor {
+        public:
+            GzipDecompressor(csv::string_view filename)
+                : _source(std::string(filename), std::ios::binary), _in(COMPRESSED_READ_SIZE) {
+                _stream.zalloc = Z_NULL;
+                _stream.zfree = Z_NULL;
+                _stream.opaque = Z_NULL;
+                _stream.next_in = Z_NULL;
+                _stream.avail_in = 0;
+
+                // Add 16 to the window size to expect a gzip header
+                if (inflateInit2(&_stream, 16 + MAX_WBITS) != Z_OK)
+                    throw std::runtime_error("Could not initialize zlib");
+            }
+
+            ~GzipDecompressor() {
+                inflateEnd(&_stream);
+            }
+
+            size_t read(char* out, size_t length) override {
+                _stream.next_out = (Bytef*)out;
+                _stream.avail_out = (uInt)length;
+
+                while (_stream.avail_out > 0) {
+                    if (_stream.avail_in == 0) {
+                        _source.read(_in.data(), (std::streamsize)_in.size());
+                        _stream.next_in = (Bytef*)_in.data();
+                        _stream.avail_in = (uInt)_source.gcount();
+
+                        if (_stream.avail_in == 0) {
+                            if (_in_member)
+                                throw std::runtime_error("Unexpected end of gzip data");
+                            break;
+                        }
+                    }
+
+                    const int result = inflate(&_stream, Z_NO_FLUSH);
+                    if (result == Z_STREAM_END) {
+                        // Another member may follow
+                        inflateReset(&_stream);
+                        _in_member = false;
+                    }
+                    else if (result == Z_OK) {
+                        _in_member = true;
+                    }
+                    else if (result != Z_BUF_ERROR) {
+                        throw std::runtime_error(std::string("Invalid gzip data: ")
+                            + (_stream.msg ? _stream.msg : "unknown error"));
+                    }
+                }
+
+                return length - _stream.avail_out;
+            }
+
+        private:
+            std::ifstream _source;
+            std::vector<char> _in;
+            z_stream _stream;
+
+            /** Whether or not we are in the middle of a gzip member */
+            bool _in_member = false;
+        };
+#endif
+
+#ifdef CSV_HAS_ZSTD
+        /** Decompresses Zstandard files, including ones made of several concatenated frames */
+        class ZstdDecompressor : public Decompressor {
+        public:
+            ZstdDecompressor(csv::string_view filename)
+                : _source(std::string(filename), std::ios::binary), _in(ZSTD_DStreamInSize()) {
+                _stream = ZSTD_createDStream();
+                if (!_stream || ZSTD_isError(ZSTD_initDStream(_stream)))
+                    throw std::runtime_error("Could not initialize zstd");
+            }
+
+            ~ZstdDecompressor() {
+                ZSTD_freeDStream(_stream);
+            }
+
+            size_t read(char* out, size_t length) override {
+                ZSTD_outBuffer output = { out, length, 0 };
+
+                while (output.pos < output.size) {
+                    if (_input.pos == _input.size) {
+                        _source.read(_in.data(), (std::streamsize)_in.size());
+                        _input = { _in.data(), (size_t)_source.gcount(), 0 };
+
+                        if (_input.size == 0) {
+                            if (_in_frame)
+                                throw std::runtime_error("Unexpected end of zstd data");
+                            break;
+                        }
+                    }
+
+                    const size_t result = ZSTD_decompressStream(_stream, &output, &_input);
+                    if (ZSTD_isError(result))
+                        throw std::runtime_error(std::string("Invalid zstd data: ") + ZSTD_getErrorName(result));
+
+                    // 0 means a frame was completely decoded and flushed
+                    _in_frame = result != 0;
+                }
+
+                return output.pos;
+            }
+
+        private:
+            std::ifstream _source;
+            std::vector<char> _in;
+            ZSTD_DStream* _stream = nullptr;
+            ZSTD_inBuffer _input = { nullptr, 0, 0 };
+
+            /** Whether or not we are in the middle of a zstd frame */
+            bool _in_frame = false;
+        };
+#endif
+
+        CSV_INLINE std::unique_ptr<Decompressor> make_decompressor(csv::string_view filename, Compression type) {
+            switch (type) {
+            case Compression::GZIP:
+#ifdef CSV_HAS_ZLIB
+                return std::unique_ptr<Decompressor>(new GzipDecompressor(filename)); // For C++11
+#else
+                throw std::runtime_error(std::string(filename) +
+                    " is gzip compressed, but CSV_HAS_ZLIB was not defined when compiling");
+#endif
+            case Compression::ZSTD:
+#ifdef CSV_HAS_ZSTD
+                return std::unique_ptr<Decompressor>(new ZstdDecompressor(filename)); // For C++11
+#else
+                throw std::runtime_error(std::string(filename) +
+                    " is zstd compressed, but CSV_HAS_ZSTD was not defined when compiling");
+#endif
+            default:
+                throw std::runtime_error(std::string(filename) + " is not compressed");
+            }
+        }
+
+        CSV_INLINE std::string decompress_head(csv::string_view filename, Compression type, size_t length) {
+            auto decompressor = make_decompressor(filename, type);
+            std::string head(length, '\0');
+
+            size_t size = 0;
+            while (size < length) {
+                const size_t n = decompressor->read(&head[size], length - size);
+                if (n == 0) break;
+                size += n;
+            }
+
+            head.resize(size);
+            return head;
+        }
+    }
+}
@@ -0,0 +1,66 @@
+/** @file
+ *  @brief Support for reading compressed CSV files
+ *
+ *  gzip support requires CSV_HAS_ZLIB to be defined and linking against zlib.
+ *  Zstandard support requires CSV_HAS_ZSTD to be defined and linking against libzstd.
+ */
+
+#pragma once
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include "common.hpp"
+#include "csv_read_ahead.hpp"
+
+namespace csv {
+    namespace internals {
+        /** Compression formats recognized by CSVReader */
+        enum class Compression {
+            NONE,
+            GZIP,
+            ZSTD
+        };
+
+        /** Identify the compression format of a file from its magic bytes */
+        Compression detect_compression(csv::string_view filename);
+
+        /** Decompresses a file incrementally
+         *
+         *  @note read() throws std::runtime_error if the file is corrupt or truncated
+         */
+        class Decompressor : public BlockReader {};
+
+        /** Create a decompressor for a file compressed with `type`
+         *
+         *  @throws std::runtime_error If support for `type` was not compiled in
+         */
+        std::unique_ptr<Decompressor> make_decompressor(csv::string_view filename, Compression type);
+
+        /** Return up to the first `length` decompressed bytes of a file */
+        std::string decompress_head(csv::string_view filename, Compression type, size_t length);
+
+        /** Parser for compressed files
+         *
+         *  @par Implementation
+         *  A worker thread decompresses the file into blocks, which are passed
+         *  through a BlockQueue so that decompression and parsing overlap while
+         *  using a bounded amount of memory.
+         */
+        class DecompressingParser : public ReadAheadParser {
+        public:
+            DecompressingParser(csv::string_view filename,
+                Compression type,
+                const CSVFormat& format,
+                const ColNamesPtr& col_names = nullptr
+            ) : ReadAheadParser(make_decompressor(filename, type), READ_SIZE, MAX_BLOCKS, format, col_names) {}
+
+        private:
+            /** Most bytes decompressed at once */
+            static constexpr size_t READ_SIZE = 1 << 20;
+
+            /** How many decompressed blocks, each as large as a chunk, may be waiting to be parsed */
+            static constexpr size_t MAX_BLOCKS = 2;
+        };
+    }
+}
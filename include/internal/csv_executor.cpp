@@ -0,0 +1,209 @@
+/** @file
+ *  @brief A thread pool whose idle threads steal work from busy ones
+ */
+
+#include <algorithm>
+
+#include "csv_executor.hpp"
+
+namespace csv {
+    CSV_INLINE void TaskGroup::wait() {
+        std::unique_lock<std::mutex> lock(this->_lock);
+        this->_cond.wait(lock, [this] { return this->_pending == 0; });
+
+        if (this->_error) {
+            auto error = this->_error;
+            this->_error = nullptr;
+            std::rethrow_exception(error);
+        }
+    }
+
+    CSV_INLINE void TaskGroup::add(size_t max_pending) {
+        std::unique_lock<std::mutex> lock(this->_lock);
+        this->_cond.wait(lock, [this, max_pending] { return this->_pending < max_pending; });
+        this->_pending++;
+    }
+
+    CSV_INLINE bool TaskGroup::try_add(size_t max_pending) {
+        std::lock_guard<std::mutex> lock(this->_lock);
+        if (this->_pending >= max_pending)
+            return false;
+
+        this->_pending++;
+        return true;
+    }
+
+    CSV_INLINE void TaskGroup::finish(std::exception_ptr error) {
+        std::lock_guard<std::mutex> lock(this->_lock);
+        if (error && !this->_error) {
+            this->_error = error;
+            this->_failed.store(true, std::memory_order_release);
+        }
+
+        this->_pending--;
+        this->_cond.notify_all();
+    }
+
+    CSV_INLINE Executor::Executor(size_t n_threads) {
+        if (n_threads == 0)
+            n_threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+        for (size_t i = 0; i < n_threads; i++)
+            this->_queues.push_back(std::unique_ptr<Queue>(new Queue())); // For C++11
+
+        for (size_t i = 0; i < n_threads; i++)
+            this->_threads.push_back(std::thread(&Executor::work, this, i));
+    }
+
+    CSV_INLINE Executor::~Executor() {
+        {
+            std::lock_guard<std::mutex> lock(this->_lock);
+            this->_stop = true;
+        }
+
+        this->_cond.notify_all();
+        for (auto& thread : this->_threads)
+            thread.join();
+    }
+
+    CSV_INLINE Executor& Executor::shared() {
+        // Deliberately leaked, so its threads are never joined during static destruction
+        static Executor* executor = new Executor();
+        return *executor;
+    }
+
+    CSV_INLINE void Executor::submit(TaskGroup& group, Task task, size_t max_pending) {
+        // The caller may itself be the only thread which could finish a task of `group`
+        while (!group.try_add(max_pending)) {
+            if (!this->run_pending(group)) {
+                // Every unfinished task is already running
+                group.add(max_pending);
+                break;
+            }
+        }
+
+        this->enqueue({ &group, std::move(task) });
+    }
+
+    CSV_INLINE void Executor::post(Task task) {
+        this->enqueue({ nullptr, std::move(task) });
+    }
+
+    CSV_INLINE void Executor::enqueue(Entry&& entry) {
+        auto& queue = *this->_queues[this->_next.fetch_add(1, std::memory_order_relaxed) % this->_queues.size()];
+        {
+            std::lock_guard<std::mutex> lock(queue.lock);
+            queue.entries.push_back(std::move(entry));
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(this->_lock);
+            this->_queued.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        this->_cond.notify_one();
+    }
+
+    CSV_INLINE void Executor::wait(TaskGroup& group) {
+        Entry entry;
+        while (this->take(group, entry))
+            run(entry);
+
+        // Whatever is left is already running on other threads
+        group.wait();
+    }
+
+    CSV_INLINE bool Executor::run_pending(TaskGroup& group) {
+        Entry entry;
+        if (!this->take(group, entry))
+            return false;
+
+        run(entry);
+        return true;
+    }
+
+    CSV_INLINE bool Executor::take(size_t i, Entry& entry) {
+        const size_t n_queues = this->_queues.size();
+        for (size_t j = 0; j < n_queues; j++) {
+            auto& queue = *this->_queues[(i + j) % n_queues];
+            std::lock_guard<std::mutex> lock(queue.lock);
+            if (queue.entries.empty())
+                continue;
+
+            // Steal from the other end of the queue than its owner takes from
+            if (j == 0) {
+                entry = std::move(queue.entries.front());
+                queue.entries.pop_front();
+            }
+            else {
+                entry = std::move(queue.entries.back());
+                queue.entries.pop_back();
+            }
+
+            this->_queued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        return false;
+    }
+
+    CSV_INLINE bool Executor::take(const TaskGroup& group, Entry& entry) {
+        for (auto& queue : this->_queues) {
+            std::lock_guard<std::mutex> lock(queue->lock);
+            auto it = std::find_if(queue->entries.begin(), queue->entries.end(),
+                [&group](const Entry& queued) { return queued.group == &group; });
+
+            if (it == queue->entries.end())
+                continue;
+
+            entry = std::move(*it);
+            queue->entries.erase(it);
+            this->_queued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        return false;
+    }
+
+    CSV_INLINE void Executor::run(Entry& entry) {
+        if (!entry.group) {
+            try { entry.task(); }
+            catch (...) {}
+
+            entry.task = nullptr;
+            return;
+        }
+
+        std::exception_ptr error = nullptr;
+        if (!entry.group->failed()) {
+            try {
+                entry.task();
+            }
+            catch (...) {
+                error = std::current_exception();
+            }
+        }
+
+        // Release whatever the task holds before its group is told it finished
+        entry.task = nullptr;
+        entry.group->finish(error);
+    }
+
+    CSV_INLINE void Executor::work(size_t i) {
+        while (true) {
+            Entry entry;
+            if (this->take(i, entry)) {
+                run(entry);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(this->_lock);
+            this->_cond.wait(lock, [this] {
+                return this->_queued.load(std::memory_order_relaxed) > 0 || this->_stop;
+            });
+
+            if (this->_stop && this->_queued.load(std::memory_order_relaxed) == 0)
+                return;
+        }
+    }
+}
@@ -0,0 +1,186 @@
+/** @file
+ *  @brief A thread pool whose idle threads steal work from busy ones
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "common.hpp"
+
+namespace csv {
+    /** Tracks a set of tasks submitted to an Executor, so that they can be waited for */
+    class TaskGroup {
+    public:
+        TaskGroup() = default;
+        TaskGroup(const TaskGroup&) = delete;
+        TaskGroup& operator=(const TaskGroup&) = delete;
+
+        /** Wait for every task in this group to finish
+         *
+         *  @throws The first exception thrown by any of them
+         *  @see    Executor::wait()
+         */
+        void wait();
+
+        /** Whether a task in this group threw an exception
+         *
+         *  @note Tasks which were not started yet are skipped once this is true
+         */
+        bool failed() const noexcept { return this->_failed.load(std::memory_order_acquire); }
+
+    private:
+        friend class Executor;
+
+        std::mutex _lock;
+        std::condition_variable _cond;
+        size_t _pending = 0;
+        std::exception_ptr _error = nullptr;
+        std::atomic<bool> _failed{ false };
+
+        /** Wait until fewer than `max_pending` tasks are unfinished, then count one more */
+        void add(size_t max_pending);
+
+        /** Count one more task if fewer than `max_pending` are unfinished, without waiting */
+        bool try_add(size_t max_pending);
+
+        /** Called after a task in this group ran */
+        void finish(std::exception_ptr error);
+    };
+
+    /** A fixed set of threads which run the tasks of any number of CSVReaders
+     *
+     *  Readers parse their chunks, parallel parsers their ranges, and CSVStat its
+     *  columns as tasks on an Executor instead of starting threads of their own.
+     *  By default they all share Executor::shared(), so opening many files at once
+     *  neither creates more threads nor runs more of them than there are cores.
+     *  Use CSVFormat::executor() to give readers a pool of a different size.
+     *
+     *  @par Implementation
+     *  Every thread has its own queue, and tasks are spread over the queues round
+     *  robin. A thread runs the oldest task in its own queue, and once that is empty,
+     *  steals the newest task from another thread's queue. When some tasks take much
+     *  longer than others, idle threads therefore keep taking work off busy ones.
+     *
+     *  @par Example
+     *  @code
+     *  // Parse with at most 4 threads, however many files are open
+     *  Executor executor(4);
+     *  CSVFormat format;
+     *  format.executor(executor);
+     *
+     *  std::vector<std::unique_ptr<CSVReader>> readers;
+     *  for (auto& file : files)
+     *      readers.push_back(std::unique_ptr<CSVReader>(new CSVReader(file, format)));
+     *  @endcode
+     *
+     *  @warning An Executor has to outlive every reader which uses it
+     */
+    class Executor {
+    public:
+        using Task = std::function<void()>;
+
+        /** @param[in] n_threads Number of threads (0 for one per hardware thread) */
+        Executor(size_t n_threads = 0);
+
+        /** Waits for queued tasks to finish */
+        ~Executor();
+
+        Executor(const Executor&) = delete;
+        Executor& operator=(const Executor&) = delete;
+
+        /** The executor used by readers whose CSVFormat does not name one,
+         *  which has one thread per hardware thread
+         *
+         *  @note Its threads are started when it is first used. It is never destroyed,
+         *        so readers in static objects may still use it during program exit.
+         */
+        static Executor& shared();
+
+        /** Number of threads */
+        size_t size() const noexcept { return this->_threads.size(); }
+
+        /** Queue `task` as part of `group`
+         *
+         *  @param[in] max_pending Wait while `group` has this many unfinished tasks,
+         *                         running its queued tasks on the calling thread
+         */
+        void submit(TaskGroup& group, Task task,
+            size_t max_pending = std::numeric_limits<size_t>::max());
+
+        /** Queue a task which nobody waits for
+         *
+         *  @note Exceptions thrown by `task` are ignored
+         */
+        void post(Task task);
+
+        /** Wait for every task in `group` to finish, running the ones which were
+         *  not started yet on the calling thread
+         *
+         *  Because the caller does not depend on a thread of the pool becoming
+         *  free, tasks may wait for groups of their own without deadlocking.
+         *
+         *  @throws The first exception thrown by a task in `group`
+         */
+        void wait(TaskGroup& group);
+
+        /** Run one task of `group` which was not started yet on the calling thread
+         *
+         *  Like wait(), this lets a thread which would otherwise block on the
+         *  results of `group` do the work itself.
+         *
+         *  @returns False if no task of `group` is queued
+         */
+        bool run_pending(TaskGroup& group);
+
+    private:
+        struct Entry {
+            TaskGroup* group; /**< nullptr for tasks queued by post() */
+            Task task;
+        };
+
+        struct Queue {
+            std::mutex lock;
+            std::deque<Entry> entries;
+        };
+
+        std::vector<std::unique_ptr<Queue>> _queues;
+        std::vector<std::thread> _threads;
+
+        /** Number of tasks waiting in queues */
+        std::atomic<size_t> _queued{ 0 };
+
+        /** Which queue the next task goes into */
+        std::atomic<size_t> _next{ 0 };
+
+        /** Idle threads sleep on _cond, which is guarded by _lock */
+        std::mutex _lock;
+        std::condition_variable _cond;
+        bool _stop = false;
+
+        /** Run by every thread */
+        void work(size_t i);
+
+        /** Take a task from queue `i`, or steal one from another queue */
+        bool take(size_t i, Entry& entry);
+
+        /** Take any queued task of `group` */
+        bool take(const TaskGroup& group, Entry& entry);
+
+        /** Queue a task which already was counted by its group */
+        void enqueue(Entry&& entry);
+
+        /** Run a task unless its group already failed, and tell its group it finished */
+        static void run(Entry& entry);
+    };
+}
@@ -47,6 +47,18 @@ namespace csv {
         return *this;
     }
 
+    CSV_INLINE CSVFormat& CSVFormat::select_columns(const std::vector<std::string>& names) {
+        this->selected_names = names;
+        this->selected_indices = {};
+        return *this;
+    }
+
+    CSV_INLINE CSVFormat& CSVFormat::select_column_indices(const std::vector<size_t>& indices) {
+        this->selected_indices = indices;
+        this->selected_names = {};
+        return *this;
+    }
+
     CSV_INLINE void CSVFormat::assert_no_char_overlap()
     {
         auto delims = std::set<char>(
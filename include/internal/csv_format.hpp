@@ -3,12 +3,17 @@
  */
 
 #pragma once
+#include <algorithm>
+#include <functional>
+#include <initializer_list>
 #include <iterator>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #include "common.hpp"
+#include "csv_executor.hpp"
 
 namespace csv {
     namespace internals {
@@ -16,6 +21,10 @@ namespace csv {
     }
 
     class CSVReader;
+    class CSVRow;
+
+    /** A predicate which returns true if a row should be kept */
+    using RowFilter = std::function<bool(const CSVRow&)>;
 
     /** Determines how to handle rows that are shorter or longer than the majority */
     enum class VariableColumnPolicy {
@@ -86,12 +95,156 @@ namespace csv {
             return *this;
         }
 
+        /** Only parse the columns with the specified names
+         *
+         *  The parser skips over the fields of every other column, so rows
+         *  only contain the selected columns (in the order they appear in the file).
+         *
+         *  @note Unsets any values set by the overloads of select_columns() which take column positions
+         */
+        CSVFormat& select_columns(const std::vector<std::string>& names);
+
+        /** Only parse the columns at the specified (zero-based) positions
+         *
+         *  @note Unsets any values set by select_columns(const std::vector<std::string>&)
+         */
+        CSVFormat& select_columns(std::initializer_list<size_t> indices) {
+            return this->select_column_indices(std::vector<size_t>(indices));
+        }
+
+        /** Only parse the columns at the positions in a container of integers
+         *
+         *  @note Unsets any values set by select_columns(const std::vector<std::string>&)
+         */
+        template<typename TContainer,
+            csv::enable_if_t<std::is_integral<typename TContainer::value_type>::value, int> = 0>
+        CSVFormat& select_columns(const TContainer& indices) {
+            return this->select_column_indices(std::vector<size_t>(indices.begin(), indices.end()));
+        }
+
+        /** Only keep rows which satisfy `predicate`
+         *
+         *  Filters are run by the thread which parses the CSV, so rows which
+         *  are rejected never reach CSVReader::read_row(). If this method is called
+         *  more than once, rows must satisfy every filter.
+         *
+         *  @note Rows before the header and rows with the wrong number of
+         *        columns (unless the variable column policy is KEEP) are not filtered.
+         *  @note Exceptions thrown by `predicate` are rethrown by CSVReader::read_row()
+         *
+         *  @see column_equals(), column_between(), column_starts_with()
+         */
+        CSVFormat& filter(RowFilter predicate) {
+            this->row_filters.push_back(std::move(predicate));
+            return *this;
+        }
+
         /** Turn quoting on or off */
         CSVFormat& quote(bool use_quote) {
             this->no_quote = !use_quote;
             return *this;
         }
 
+        /** Sets the number of threads used to parse memory-mapped files
+         *
+         *  @note Each thread parses its own range of the file, and rows are
+         *        still returned in file order. Stream sources ignore this setting.
+         *  @note The ranges are parsed as tasks on the reader's Executor, which
+         *        bounds how many of them actually run at once.
+         */
+        CSVFormat& parse_threads(size_t n_threads) {
+            this->n_parse_threads = n_threads ? n_threads : 1;
+            return *this;
+        }
+
+        /** Memory map uncompressed files in their entirety instead of one window at a time
+         *
+         *  @note On POSIX systems, the kernel is asked to read ahead of the parser and
+         *        the pages of rows which are no longer referenced are released, so
+         *        memory usage stays bounded even though the whole file is mapped.
+         *
+         *  @param[in] prefault Ask the kernel to read the whole file in up front
+         *                      (`MAP_POPULATE`, only supported on Linux)
+         */
+        CSVFormat& map_whole_file(bool enabled = true, bool prefault = false) {
+            this->whole_file_mapping = enabled;
+            this->prefault_mapping = enabled && prefault;
+            return *this;
+        }
+
+        /** Read uncompressed files with pread() on a worker thread instead of memory mapping them
+         *
+         *  @note This avoids the page faults of memory mapped files and bounds how much
+         *        of the file is buffered, which helps when many readers share a host.
+         *
+         *  @param[in] queue_depth How many chunks may be read ahead of the parser (0 memory maps files)
+         *  @param[in] direct_io   Bypass the page cache (`O_DIRECT` on Linux, `F_NOCACHE` on macOS),
+         *                         e.g. for one-off scans of files which will not be read again
+         */
+        CSVFormat& read_with_pread(size_t queue_depth = 2, bool direct_io = false) {
+            this->pread_depth = queue_depth;
+            this->direct_io = queue_depth > 0 && direct_io;
+            return *this;
+        }
+
+        /** Sets how many chunks CSVReader may parse ahead of the rows that were read
+         *
+         *  Chunks are parsed on the reader's Executor while rows are being read, which
+         *  pauses once this many chunks are queued up. Larger values smooth out uneven parsing
+         *  and processing times, at the cost of holding more chunks in memory.
+         *
+         *  @see chunk_size()
+         */
+        CSVFormat& read_ahead(size_t n_chunks) {
+            this->read_ahead_chunks = n_chunks ? n_chunks : 1;
+            return *this;
+        }
+
+        /** Sets the thread pool which parses for readers using this format
+         *
+         *  By default, every reader shares Executor::shared().
+         *
+         *  @note `exec` has to outlive these readers
+         */
+        CSVFormat& executor(Executor& exec) {
+            this->task_executor = &exec;
+            return *this;
+        }
+
+        /** Sets how many bytes are parsed at a time when reading files and streams
+         *
+         *  @note Unsets any values set by adaptive_chunk_size()
+         */
+        CSVFormat& chunk_size(size_t bytes) {
+            this->chunk_size_bytes = bytes ? bytes : 1;
+            this->adaptive_chunking = false;
+            return *this;
+        }
+
+        /** Let the reader choose how many bytes are parsed at a time
+         *
+         *  Chunks grow while the rows are small and the consumer keeps up with the
+         *  parser, and shrink when the rows of the chunks which may be held at once
+         *  would not fit in `memory_limit`. Use CSVReader::chunk_size() to find out
+         *  what was chosen.
+         *
+         *  @param[in] memory_limit Approximate number of bytes the parsed rows of a
+         *                          reader may use (0 for no limit)
+         *  @param[in] min_bytes    Smallest chunk size
+         *  @param[in] max_bytes    Largest chunk size
+         *
+         *  @note Starts from the size given to chunk_size(), if any
+         *  @note The memory limit does not push chunks below `min_bytes`
+         */
+        CSVFormat& adaptive_chunk_size(size_t memory_limit = 0,
+            size_t min_bytes = 1 << 20, size_t max_bytes = 1 << 28) {
+            this->adaptive_chunking = true;
+            this->chunk_memory_limit = memory_limit;
+            this->min_chunk_size = min_bytes ? min_bytes : 1;
+            this->max_chunk_size = std::max(max_bytes, this->min_chunk_size);
+            return *this;
+        }
+
         /** Tells the parser how to handle columns of a different length than the others */
         CONSTEXPR_14 CSVFormat& variable_columns(VariableColumnPolicy policy = VariableColumnPolicy::IGNORE_ROW) {
             this->variable_column_policy = policy;
@@ -117,9 +270,25 @@ namespace csv {
         CONSTEXPR bool is_quoting_enabled() const { return !this->no_quote; }
         CONSTEXPR char get_quote_char() const { return this->quote_char; }
         CONSTEXPR int get_header() const { return this->header; }
+        std::vector<std::string> get_col_names() const { return this->col_names; }
         std::vector<char> get_possible_delims() const { return this->possible_delimiters; }
         std::vector<char> get_trim_chars() const { return this->trim_chars; }
         CONSTEXPR VariableColumnPolicy get_variable_column_policy() const { return this->variable_column_policy; }
+        CONSTEXPR size_t get_parse_threads() const { return this->n_parse_threads; }
+        CONSTEXPR bool get_map_whole_file() const { return this->whole_file_mapping; }
+        CONSTEXPR bool get_prefault_mapping() const { return this->prefault_mapping; }
+        CONSTEXPR size_t get_pread_depth() const { return this->pread_depth; }
+        CONSTEXPR bool get_direct_io() const { return this->direct_io; }
+        CONSTEXPR size_t get_read_ahead() const { return this->read_ahead_chunks; }
+        Executor& get_executor() const { return this->task_executor ? *this->task_executor : Executor::shared(); }
+        CONSTEXPR size_t get_chunk_size() const { return this->chunk_size_bytes; }
+        CONSTEXPR bool get_adaptive_chunking() const { return this->adaptive_chunking; }
+        CONSTEXPR size_t get_chunk_memory_limit() const { return this->chunk_memory_limit; }
+        CONSTEXPR size_t get_min_chunk_size() const { return this->min_chunk_size; }
+        CONSTEXPR size_t get_max_chunk_size() const { return this->max_chunk_size; }
+        std::vector<std::string> get_selected_names() const { return this->selected_names; }
+        std::vector<size_t> get_selected_indices() const { return this->selected_indices; }
+        bool has_column_selection() const { return !this->selected_names.empty() || !this->selected_indices.empty(); }
         #endif
         
         /** CSVFormat for guessing the delimiter */
@@ -143,6 +312,9 @@ namespace csv {
         /**< Throws an error if delimiters and trim characters overlap */
         void assert_no_char_overlap();
 
+        /**< Implementation of select_columns() for column positions */
+        CSVFormat& select_column_indices(const std::vector<size_t>& indices);
+
         /**< Set of possible delimiters */
         std::vector<char> possible_delimiters = { ',' };
 
@@ -161,7 +333,83 @@ namespace csv {
         /**< Should be left empty unless file doesn't include header */
         std::vector<std::string> col_names = {};
 
+        /**< Names of the columns to parse (empty if every column should be parsed) */
+        std::vector<std::string> selected_names = {};
+
+        /**< Positions of the columns to parse (empty if every column should be parsed) */
+        std::vector<size_t> selected_indices = {};
+
+        /**< Predicates which rows must satisfy */
+        std::vector<RowFilter> row_filters = {};
+
         /**< Allow variable length columns? */
         VariableColumnPolicy variable_column_policy = VariableColumnPolicy::IGNORE_ROW;
+
+        /**< Number of threads used to parse memory-mapped files */
+        size_t n_parse_threads = 1;
+
+        /**< Map entire files instead of moving windows over them */
+        bool whole_file_mapping = false;
+
+        /**< Prefault whole file mappings */
+        bool prefault_mapping = false;
+
+        /**< How many blocks to read ahead with pread() (0 if files should be memory mapped) */
+        size_t pread_depth = 0;
+
+        /**< Bypass the page cache when reading with pread() */
+        bool direct_io = false;
+
+        /**< How many chunks CSVReader may parse ahead of the consumer */
+        size_t read_ahead_chunks = 2;
+
+        /**< Thread pool used by readers (nullptr for Executor::shared()) */
+        Executor* task_executor = nullptr;
+
+        /**< How many bytes are parsed at a time (or the first chunk size if adaptive_chunking is set) */
+        size_t chunk_size_bytes = internals::ITERATION_CHUNK_SIZE;
+
+        /**< Let the reader choose the chunk size */
+        bool adaptive_chunking = false;
+
+        /**< Limits on adaptive chunk sizes */
+        size_t chunk_memory_limit = 0;
+        size_t min_chunk_size = 0;
+        size_t max_chunk_size = 0;
+    };
+
+    /** A CSVFormat whose delimiter and quote character are fixed at compile time
+     *
+     *  A CSVReader constructed with a StaticCSVFormat uses a parser specialized for
+     *  this dialect, where classifying each character reduces to a few comparisons
+     *  against constants and quote handling is compiled out if `UseQuote` is false.
+     *
+     *  @tparam Delim    The delimiter
+     *  @tparam Quote    The quote character
+     *  @tparam UseQuote Whether or not quoting is enabled
+     *
+     *  @note Because the setters of CSVFormat return a `CSVFormat&`, they should be
+     *        called on a named StaticCSVFormat rather than chained onto a temporary.
+     *        If the delimiter, quote character or trim characters are changed,
+     *        CSVReader falls back to the generic parser.
+     */
+    template<char Delim = ',', char Quote = '"', bool UseQuote = true>
+    class StaticCSVFormat : public CSVFormat {
+    public:
+        StaticCSVFormat() {
+            this->delimiter(Delim).quote(Quote).quote(UseQuote);
+        }
+
+        /** Whether or not the dialect settings still match the template arguments */
+        bool is_static_dialect() const {
+            return this->get_possible_delims().size() == 1
+                && this->get_delim() == Delim
+                && this->is_quoting_enabled() == UseQuote
+                && (!UseQuote || this->get_quote_char() == Quote)
+                && this->get_trim_chars().empty();
+        }
     };
+
+    /** A StaticCSVFormat for RFC 4180 CSV files */
+    using RFC4180Format = StaticCSVFormat<',', '"'>;
 }
\ No newline at end of file
@@ -0,0 +1,263 @@
+/** @file
+ *  @brief Reads many CSV files with the same columns as one stream of rows
+ */
+
+#include <algorithm>
+
+#include "csv_multi_reader.hpp"
+
+namespace csv {
+    CSV_INLINE std::vector<std::string> glob_files(csv::string_view pattern) {
+        std::vector<std::string> paths;
+
+#if defined(CSV_HAS_GLOB)
+        glob_t matches;
+        const int result = glob(std::string(pattern).c_str(), 0, nullptr, &matches);
+        if (result == 0) {
+            for (size_t i = 0; i < matches.gl_pathc; i++)
+                paths.push_back(matches.gl_pathv[i]);
+        }
+
+        globfree(&matches);
+        if (result != 0 && result != GLOB_NOMATCH)
+            throw std::runtime_error("Cannot expand " + std::string(pattern));
+#elif defined(_WIN32)
+        // FindFirstFileA() only returns file names, without their directory
+        const std::string pattern_str(pattern);
+        const size_t slash = pattern_str.find_last_of("/\\");
+        const std::string dir = slash == std::string::npos ? "" : pattern_str.substr(0, slash + 1);
+
+        WIN32_FIND_DATAA data;
+        HANDLE handle = FindFirstFileA(pattern_str.c_str(), &data);
+        if (handle != INVALID_HANDLE_VALUE) {
+            do {
+                if (!(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+                    paths.push_back(dir + data.cFileName);
+            } while (FindNextFileA(handle, &data));
+
+            FindClose(handle);
+        }
+#else
+        throw std::runtime_error("glob_files() is not supported on this platform");
+#endif
+
+        std::sort(paths.begin(), paths.end());
+        return paths;
+    }
+
+    CSV_INLINE MultiCSVReader::MultiCSVReader(std::vector<std::string> filenames, CSVFormat format,
+        ShardOrder order, size_t n_open) :
+        _filenames(std::move(filenames)), _format(format), _order(order),
+        _n_open(n_open ? n_open : format.get_executor().size()) {
+        if (this->_filenames.empty())
+            return;
+
+        // Only the first file's format is guessed
+        std::unique_ptr<Shard> first(new Shard()); // For C++11
+        first->filename = this->_filenames[0];
+        first->reader = std::unique_ptr<CSVReader>(new CSVReader(first->filename, format)); // For C++11
+        first->opened = true;
+
+        if (format.guess_delim()) {
+            const CSVFormat guessed = first->reader->get_format();
+            this->_format.delimiter(guessed.get_delim());
+            if (format.get_col_names().empty())
+                this->_format.header_row(guessed.get_header());
+        }
+
+        this->_col_names = first->reader->get_col_names();
+        first->reader->start_read_ahead();
+        this->_shards.push_back(std::move(first));
+        this->_next_file = 1;
+
+        while (this->_shards.size() < this->_n_open && this->_next_file < this->_filenames.size())
+            this->open_next();
+    }
+
+    CSV_INLINE MultiCSVReader::~MultiCSVReader() {
+        this->_closing.store(true, std::memory_order_release);
+        try { this->_format.get_executor().wait(this->_open_tasks); }
+        catch (...) {}
+
+        // Stop parsing before anything the parsing tasks may notify goes away
+        this->_shards.clear();
+    }
+
+    CSV_INLINE bool MultiCSVReader::read_row(CSVRow& row) {
+        if (this->_row_pos == this->_row_buffer.size()) {
+            this->_row_pos = 0;
+            if (!this->fill(this->_row_buffer, internals::RowBatchQueue::BATCH_SIZE))
+                return false;
+        }
+
+        row = std::move(this->_row_buffer.rows[this->_row_pos++]);
+        this->_n_rows++;
+        return true;
+    }
+
+    CSV_INLINE bool MultiCSVReader::read_rows(RowBatch& batch, size_t max_rows) {
+        // Hand out rows which read_row() already fetched first
+        if (this->_row_pos < this->_row_buffer.size()) {
+            batch.rows.clear();
+            while (batch.rows.size() < max_rows && this->_row_pos < this->_row_buffer.size())
+                batch.rows.push_back(std::move(this->_row_buffer.rows[this->_row_pos++]));
+        }
+        else if (!this->fill(batch, max_rows)) {
+            return false;
+        }
+
+        this->_n_rows += batch.size();
+        return true;
+    }
+
+    CSV_INLINE bool MultiCSVReader::fill(RowBatch& batch, size_t max_rows) {
+        if (this->_order == ShardOrder::FILE_ORDER)
+            return this->fill_in_file_order(batch, max_rows);
+
+        return this->fill_in_arrival_order(batch, max_rows);
+    }
+
+    CSV_INLINE bool MultiCSVReader::fill_in_file_order(RowBatch& batch, size_t max_rows) {
+        while (!this->_shards.empty()) {
+            this->wait_opened(0);
+
+            auto& shard = *this->_shards.front();
+            if (shard.reader->read_rows(batch, max_rows)) {
+                this->_current_file = shard.filename;
+                return true;
+            }
+
+            this->close(0);
+        }
+
+        return false;
+    }
+
+    CSV_INLINE bool MultiCSVReader::fill_in_arrival_order(RowBatch& batch, size_t max_rows) {
+        while (!this->_shards.empty()) {
+            bool closed = false;
+
+            // Start after the file read from last, so that no file is starved
+            for (size_t j = 0; j < this->_shards.size() && !closed; j++) {
+                const size_t i = (this->_next_shard + j) % this->_shards.size();
+                auto& shard = *this->_shards[i];
+                {
+                    std::lock_guard<std::mutex> lock(this->_lock);
+                    if (!shard.opened) continue;
+                }
+
+                if (shard.error)
+                    this->wait_opened(i);
+
+                if (!shard.reader->batch_ready())
+                    continue;
+
+                if (shard.reader->read_rows(batch, max_rows)) {
+                    this->_current_file = shard.filename;
+                    this->_next_shard = i + 1;
+                    return true;
+                }
+
+                this->close(i);
+                closed = true;
+            }
+
+            if (!closed)
+                this->wait_for_arrival();
+        }
+
+        return false;
+    }
+
+    CSV_INLINE void MultiCSVReader::open_next() {
+        if (this->_next_file == this->_filenames.size())
+            return;
+
+        std::unique_ptr<Shard> shard(new Shard()); // For C++11
+        shard->filename = this->_filenames[this->_next_file++];
+
+        Shard* opening = shard.get();
+        this->_shards.push_back(std::move(shard));
+        this->_format.get_executor().submit(this->_open_tasks, [this, opening]() { this->open(*opening); });
+    }
+
+    CSV_INLINE void MultiCSVReader::open(Shard& shard) {
+        std::unique_ptr<CSVReader> reader = nullptr;
+        std::exception_ptr error = nullptr;
+
+        if (!this->_closing.load(std::memory_order_acquire)) {
+            try {
+                reader = std::unique_ptr<CSVReader>(new CSVReader(shard.filename, this->_format)); // For C++11
+                if (reader->get_col_names() != this->_col_names) {
+                    throw std::runtime_error("The columns of " + shard.filename +
+                        " do not match those of " + this->_filenames[0]);
+                }
+
+                reader->start_read_ahead();
+            }
+            catch (...) {
+                reader = nullptr;
+                error = std::current_exception();
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(this->_lock);
+        shard.reader = std::move(reader);
+        shard.error = error;
+        shard.opened = true;
+        this->_arrived = true;
+        this->_cond.notify_all();
+    }
+
+    CSV_INLINE void MultiCSVReader::wait_opened(size_t i) {
+        auto& shard = *this->_shards[i];
+        std::unique_lock<std::mutex> lock(this->_lock);
+        this->_cond.wait(lock, [&shard] { return shard.opened; });
+
+        if (shard.error) {
+            auto error = shard.error;
+            lock.unlock();
+
+            this->close(i);
+            std::rethrow_exception(error);
+        }
+    }
+
+    CSV_INLINE void MultiCSVReader::close(size_t i) {
+        this->_shards.erase(this->_shards.begin() + i);
+        if (this->_next_shard > i)
+            this->_next_shard--;
+
+        this->open_next();
+    }
+
+    CSV_INLINE void MultiCSVReader::wait_for_arrival() {
+        {
+            std::lock_guard<std::mutex> lock(this->_lock);
+            this->_arrived = false;
+        }
+
+        // Files which are opened after this point set _arrived themselves
+        for (auto& shard : this->_shards) {
+            {
+                std::lock_guard<std::mutex> lock(this->_lock);
+                if (!shard->opened) continue;
+            }
+
+            if (shard->error)
+                return;
+
+            const bool waiting = shard->reader->resume_when_ready([this]() {
+                std::lock_guard<std::mutex> lock(this->_lock);
+                this->_arrived = true;
+                this->_cond.notify_all();
+            });
+
+            if (!waiting)
+                return;
+        }
+
+        std::unique_lock<std::mutex> lock(this->_lock);
+        this->_cond.wait(lock, [this] { return this->_arrived; });
+    }
+}
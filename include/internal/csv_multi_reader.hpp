@@ -0,0 +1,190 @@
+/** @file
+ *  @brief Reads many CSV files with the same columns as one stream of rows
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "common.hpp"
+#include "csv_executor.hpp"
+#include "csv_format.hpp"
+#include "csv_reader.hpp"
+#include "csv_row.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <glob.h>
+#define CSV_HAS_GLOB
+#endif
+
+namespace csv {
+    /** Determines the order in which MultiCSVReader returns the rows of its files */
+    enum class ShardOrder {
+        FILE_ORDER,   /**< All rows of a file before any rows of the next one */
+        ARRIVAL_ORDER /**< Rows from whichever open file has parsed some first */
+    };
+
+    /** Return the paths matching a wildcard pattern such as `exports/part-*.csv`, in sorted order
+     *
+     *  @note Only the last path component may contain wildcards on Windows
+     */
+    std::vector<std::string> glob_files(csv::string_view pattern);
+
+    /** @class MultiCSVReader
+     *  @brief Reads CSV files which share the same columns, such as the shards of
+     *         an export, as if they were one file
+     *
+     *  Several files are open at once, and each of them is parsed ahead of the
+     *  consumer on the Executor of `format`, so that all cores are kept busy even
+     *  when files are small.
+     *
+     *  Only the first file's format is guessed. The other files are opened with
+     *  its delimiter and header row, and a file whose column names differ from the
+     *  first file's is reported as an error.
+     *
+     *  @par Example
+     *  @code
+     *  MultiCSVReader reader(glob_files("exports/part-*.csv"));
+     *  RowBatch batch;
+     *  while (reader.read_rows(batch, 1000)) {
+     *      for (auto& row : batch) { ... }
+     *  }
+     *  @endcode
+     */
+    class MultiCSVReader {
+    public:
+        /**
+         *  @param[in] filenames Paths to the CSV files
+         *  @param[in] format    Format of every file
+         *  @param[in] order     Order in which rows are returned
+         *  @param[in] n_open    How many files are open and parsed at once
+         *                       (0 for one per thread of the executor)
+         *
+         *  @throws If the first file cannot be read
+         */
+        MultiCSVReader(std::vector<std::string> filenames,
+            CSVFormat format = CSVFormat::guess_csv(),
+            ShardOrder order = ShardOrder::FILE_ORDER,
+            size_t n_open = 0);
+
+        /** Waits for files which are being opened */
+        ~MultiCSVReader();
+
+        MultiCSVReader(const MultiCSVReader&) = delete;
+        MultiCSVReader& operator=(const MultiCSVReader&) = delete;
+
+        /** @name Retrieving CSV Rows */
+        ///@{
+        /** Retrieve the next row, returning false once every file was read
+         *
+         *  @throws Errors from opening or parsing a file, after which the remaining
+         *          files can still be read
+         */
+        bool read_row(CSVRow& row);
+
+        /** Retrieve up to `max_rows` rows of one file, returning false once every file was read
+         *
+         *  @see CSVReader::read_rows()
+         */
+        bool read_rows(RowBatch& batch, size_t max_rows);
+        ///@}
+
+        /** @name CSV Metadata */
+        ///@{
+        /** Return the format every file is read with */
+        CSVFormat get_format() const { return this->_format; }
+
+        /** Return the column names of the first file */
+        std::vector<std::string> get_col_names() const { return this->_col_names; }
+
+        /** Return the file of the rows which were read last */
+        const std::string& current_file() const noexcept { return this->_current_file; }
+        ///@}
+
+        /** @name CSV Metadata: Attributes */
+        ///@{
+        /** Returns how many rows (minus header) have been read so far, over all files */
+        CONSTEXPR size_t n_rows() const noexcept { return this->_n_rows; }
+        ///@}
+
+    private:
+        /** A file which is being opened or read */
+        struct Shard {
+            std::string filename;
+
+            /** @name Set by the task opening this file, and guarded by _lock */
+            ///@{
+            std::unique_ptr<CSVReader> reader = nullptr;
+            std::exception_ptr error = nullptr;
+            bool opened = false;
+            ///@}
+        };
+
+        std::vector<std::string> _filenames;
+        CSVFormat _format;
+        ShardOrder _order;
+        size_t _n_open;
+
+        /** Column names every file should have */
+        std::vector<std::string> _col_names;
+
+        std::string _current_file;
+        size_t _n_rows = 0;
+
+        /** Rows fetched by read_row() which were not returned yet */
+        RowBatch _row_buffer;
+        size_t _row_pos = 0;
+
+        /** Index of the next file to open */
+        size_t _next_file = 0;
+
+        /** Index in _shards of the next file to look for rows in (ARRIVAL_ORDER only) */
+        size_t _next_shard = 0;
+
+        /** Guards the shards' opening state and _arrived */
+        std::mutex _lock;
+        std::condition_variable _cond;
+
+        /** Whether a file was opened or parsed rows since wait_for_arrival() was called */
+        bool _arrived = false;
+
+        /** Tracks the tasks opening files */
+        TaskGroup _open_tasks;
+
+        /** Tells tasks which did not open their file yet to skip it */
+        std::atomic<bool> _closing{ false };
+
+        /** Files being opened or read, in the order of _filenames */
+        std::deque<std::unique_ptr<Shard>> _shards;
+
+        /** Start opening the next file, if any */
+        void open_next();
+
+        /** Open a shard and start parsing it, on a thread of the executor */
+        void open(Shard& shard);
+
+        /** Wait until the `i`th shard is opened
+         *
+         *  @throws Errors from opening it, after removing it from _shards
+         */
+        void wait_opened(size_t i);
+
+        /** Stop reading the `i`th shard and start opening the next file */
+        void close(size_t i);
+
+        /** Wait until any open file has rows, or another file was opened */
+        void wait_for_arrival();
+
+        /** Read the next rows of one file, without counting them */
+        bool fill(RowBatch& batch, size_t max_rows);
+        bool fill_in_file_order(RowBatch& batch, size_t max_rows);
+        bool fill_in_arrival_order(RowBatch& batch, size_t max_rows);
+    };
+}
@@ -0,0 +1,71 @@
+/** @file
+ *  @brief Defines an API for parsing CSV data which is pushed in pieces
+ */
+
+#include "csv_push_parser.hpp"
+#include "csv_reader.hpp"
+
+namespace csv {
+    CSV_INLINE CSVPushParser::CSVPushParser(CSVFormat format) :
+        _format(format), acceptor(format, this->col_names) {
+        this->parser = std::unique_ptr<internals::FeedParser>(
+            new internals::FeedParser(format, this->col_names)); // For C++11
+        this->parser->set_output(this->records);
+    }
+
+    CSV_INLINE CSVPushParser::CSVPushParser(CSVFormat format, RowCallback on_row) : CSVPushParser(format) {
+        this->on_row = std::move(on_row);
+    }
+
+    /** Parse the next piece of data
+     *
+     *  Every row which is completed by `data` is passed to the callback
+     *  or made available to read_row() before this returns.
+     *
+     *  @throws std::runtime_error If called after finish()
+     */
+    CSV_INLINE void CSVPushParser::feed(const char* data, size_t length) {
+        this->parser->feed(data, length);
+        this->deliver_rows();
+    }
+
+    /** Indicate that there is no more data, which completes the last row */
+    CSV_INLINE void CSVPushParser::finish() {
+        this->parser->finish();
+        this->deliver_rows();
+    }
+
+    /** Retrieve the next completed row, returning false if there are none at the moment
+     *
+     *  @note Always returns false if this parser was created with a callback
+     */
+    CSV_INLINE bool CSVPushParser::read_row(CSVRow& row) {
+        this->acceptor.trim_header(this->records);
+
+        while (!this->records.empty()) {
+            if (!this->acceptor.accepts(this->records.front())) {
+                this->acceptor.reject(this->records.pop_front());
+            }
+            else {
+                row = this->records.pop_front();
+                this->_n_rows++;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /** Return the CSV's column names, which are empty until the header has been parsed */
+    CSV_INLINE std::vector<std::string> CSVPushParser::get_col_names() const {
+        return this->col_names->get_col_names();
+    }
+
+    CSV_INLINE void CSVPushParser::deliver_rows() {
+        if (!this->on_row) return;
+
+        CSVRow row;
+        while (this->read_row(row))
+            this->on_row(row);
+    }
+}
@@ -0,0 +1,96 @@
+/** @file
+ *  @brief Defines an API for parsing CSV data which is pushed in pieces
+ */
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "basic_csv_parser.hpp"
+#include "common.hpp"
+#include "csv_format.hpp"
+#include "csv_reader.hpp"
+
+namespace csv {
+    /** @class CSVPushParser
+     *  @brief Parses CSV data which arrives in pieces of any size, such as
+     *         reads from a socket or output from a decompression library
+     *
+     *  Completed rows are either passed to a callback as soon as they are parsed,
+     *  or queued until they are retrieved with read_row(). Partial rows, including
+     *  any open quotes, carry over from one call to feed() to the next.
+     *
+     *  Like CSVReader, rows before the header are dropped and rows with the wrong
+     *  number of columns are handled according to the variable column policy.
+     *
+     *  @par Example
+     *  @code
+     *  CSVPushParser parser(CSVFormat(), [](CSVRow& row) { ... });
+     *  while (socket.read(buffer, size))
+     *      parser.feed(buffer, size);
+     *  parser.finish();
+     *  @endcode
+     */
+    class CSVPushParser {
+    public:
+        /** Receives completed rows */
+        using RowCallback = std::function<void(CSVRow&)>;
+
+        /** @name Constructors */
+        ///@{
+        /** Create a parser whose rows are retrieved with read_row() */
+        CSVPushParser(CSVFormat format = CSVFormat());
+
+        /** Create a parser which passes each row to `on_row` */
+        CSVPushParser(CSVFormat format, RowCallback on_row);
+        ///@}
+
+        /** @name Supplying Data */
+        ///@{
+        void feed(const char* data, size_t length);
+
+        /** @copydoc feed(const char*, size_t) */
+        void feed(csv::string_view data) { this->feed(data.data(), data.size()); }
+
+        void finish();
+        ///@}
+
+        /** @name Retrieving CSV Rows */
+        ///@{
+        bool read_row(CSVRow& row);
+
+        /** Whether or not finish() has been called and every row has been retrieved */
+        bool eof() const noexcept { return this->parser->eof() && this->records.empty(); }
+        ///@}
+
+        /** @name CSV Metadata */
+        ///@{
+        std::vector<std::string> get_col_names() const;
+
+        /** Retrieves the number of rows that have been read so far */
+        CONSTEXPR size_t n_rows() const noexcept { return this->_n_rows; }
+        ///@}
+
+    private:
+        CSVFormat _format;
+        internals::ColNamesPtr col_names = std::make_shared<internals::ColNames>();
+        std::unique_ptr<internals::FeedParser> parser = nullptr;
+
+        /** Rows which have been parsed but not retrieved yet */
+        RowCollection records;
+
+        /** If set, called with each row as soon as it is parsed */
+        RowCallback on_row = nullptr;
+
+        /** Decides which parsed rows are returned */
+        internals::RowAcceptor acceptor;
+
+        size_t _n_rows = 0; /**< How many rows (minus header) have been read so far */
+
+        /** Pass every row parsed so far to on_row, if set */
+        void deliver_rows();
+    };
+}
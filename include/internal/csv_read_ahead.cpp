@@ -0,0 +1,263 @@
+/** @file
+ *  @brief Parsers which read their input in blocks on a worker thread
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include "csv_read_ahead.hpp"
+
+namespace csv {
+    namespace internals {
+        CSV_INLINE bool BlockQueue::push(std::string&& block) {
+            std::unique_lock<std::mutex> lock(_lock);
+            _not_full.wait(lock, [this] { return _blocks.size() < _capacity || _cancelled; });
+            if (_cancelled) return false;
+
+            _blocks.push_back(std::move(block));
+            _not_empty.notify_one();
+            return true;
+        }
+
+        CSV_INLINE bool BlockQueue::pop(std::string& block) {
+            std::unique_lock<std::mutex> lock(_lock);
+            _not_empty.wait(lock, [this] { return !_blocks.empty() || _finished; });
+
+            if (_blocks.empty()) {
+                if (_error) std::rethrow_exception(_error);
+                return false;
+            }
+
+            block = std::move(_blocks.front());
+            _blocks.pop_front();
+            _not_full.notify_one();
+            return true;
+        }
+
+        CSV_INLINE void BlockQueue::recycle(std::string&& block) {
+            std::lock_guard<std::mutex> lock(_lock);
+
+            // Blocks beyond what can be in flight at once would never be reused
+            if (_recycled.size() <= _capacity)
+                _recycled.push_back(std::move(block));
+        }
+
+        CSV_INLINE std::string BlockQueue::take_recycled() {
+            std::lock_guard<std::mutex> lock(_lock);
+            if (_recycled.empty()) return std::string();
+
+            std::string block = std::move(_recycled.back());
+            _recycled.pop_back();
+            return block;
+        }
+
+        CSV_INLINE void BlockQueue::finish(std::exception_ptr error) {
+            std::lock_guard<std::mutex> lock(_lock);
+            _finished = true;
+            _error = error;
+            _not_empty.notify_all();
+        }
+
+        CSV_INLINE void BlockQueue::cancel() {
+            std::lock_guard<std::mutex> lock(_lock);
+            _cancelled = true;
+            _not_full.notify_all();
+        }
+
+#ifdef CSV_HAS_PREAD
+        CSV_INLINE FileReader::FileReader(csv::string_view filename, bool direct) : _filename(filename) {
+#ifdef O_DIRECT
+            if (direct) {
+                _fd = ::open(_filename.c_str(), O_RDONLY | O_DIRECT);
+                if (_fd >= 0 && ::posix_memalign((void**)&_direct_buffer, DIRECT_ALIGNMENT, DIRECT_BLOCK_SIZE) != 0)
+                    _direct_buffer = nullptr;
+            }
+#endif
+
+            // Some file systems (e.g. tmpfs) refuse O_DIRECT
+            if (_fd < 0)
+                _fd = ::open(_filename.c_str(), O_RDONLY);
+
+            if (_fd < 0)
+                throw std::runtime_error("Cannot open file " + _filename);
+
+#ifdef F_NOCACHE
+            if (direct) ::fcntl(_fd, F_NOCACHE, 1);
+#endif
+
+            if (!direct || !_direct_buffer)
+                this->disable_direct();
+        }
+
+        CSV_INLINE FileReader::~FileReader() {
+            if (_fd >= 0) ::close(_fd);
+            std::free(_direct_buffer);
+        }
+
+        CSV_INLINE void FileReader::disable_direct() {
+#ifdef O_DIRECT
+            const int flags = ::fcntl(_fd, F_GETFL);
+            if (flags >= 0 && (flags & O_DIRECT))
+                ::fcntl(_fd, F_SETFL, flags & ~O_DIRECT);
+#endif
+
+            std::free(_direct_buffer);
+            _direct_buffer = nullptr;
+        }
+
+        CSV_INLINE size_t FileReader::read(char* out, size_t length) {
+            if (_direct_buffer)
+                return this->read_direct(out, length);
+
+            while (true) {
+                const ssize_t n = ::pread(_fd, out, length, (off_t)_pos);
+                if (n >= 0) {
+                    _pos += (size_t)n;
+                    return (size_t)n;
+                }
+
+                if (errno != EINTR)
+                    throw std::runtime_error("Error reading " + _filename + ": " + std::strerror(errno));
+            }
+        }
+
+        CSV_INLINE size_t FileReader::read_direct(char* out, size_t length) {
+            // O_DIRECT reads must be aligned, so they go through an intermediate buffer
+            if (_direct_pos == _direct_size) {
+                ssize_t n;
+                do {
+                    n = ::pread(_fd, _direct_buffer, DIRECT_BLOCK_SIZE, (off_t)_pos);
+                } while (n < 0 && errno == EINTR);
+
+                if (n < 0) {
+                    if (errno != EINVAL)
+                        throw std::runtime_error("Error reading " + _filename + ": " + std::strerror(errno));
+
+                    this->disable_direct();
+                    return this->read(out, length);
+                }
+
+                _pos += (size_t)n;
+                _direct_pos = 0;
+                _direct_size = (size_t)n;
+                if (n == 0) return 0;
+            }
+
+            length = std::min(length, _direct_size - _direct_pos);
+            std::memcpy(out, _direct_buffer + _direct_pos, length);
+            _direct_pos += length;
+            return length;
+        }
+#else
+        CSV_INLINE FileReader::FileReader(csv::string_view filename, bool)
+            : _filename(filename), _source(_filename, std::ios::binary) {
+            if (!_source.is_open())
+                throw std::runtime_error("Cannot open file " + _filename);
+        }
+
+        CSV_INLINE FileReader::~FileReader() {}
+
+        CSV_INLINE size_t FileReader::read(char* out, size_t length) {
+            _source.read(out, (std::streamsize)length);
+            if (_source.bad())
+                throw std::runtime_error("Error reading " + _filename);
+
+            return (size_t)_source.gcount();
+        }
+#endif
+
+        CSV_INLINE ReadAheadParser::ReadAheadParser(std::unique_ptr<BlockReader> reader,
+            size_t read_size, size_t depth, const CSVFormat& format, const ColNamesPtr& col_names)
+            : IStreamParser(format, col_names), _read_size(read_size), _block_size(format.get_chunk_size()), _blocks(depth) {
+            _worker = std::thread(&ReadAheadParser::read_blocks, this, std::move(reader));
+        }
+
+        CSV_INLINE ReadAheadParser::~ReadAheadParser() {
+            _blocks.cancel();
+            if (_worker.joinable())
+                _worker.join();
+        }
+
+        CSV_INLINE void ReadAheadParser::read_blocks(std::unique_ptr<BlockReader> reader) {
+            try {
+                while (true) {
+                    std::string block = _blocks.take_recycled();
+                    block.resize(CARRY_ROOM + _block_size.load(std::memory_order_relaxed));
+
+                    // Fill the whole block unless the input runs out
+                    size_t length = CARRY_ROOM;
+                    while (length < block.size()) {
+                        const size_t n = reader->read(&block[length], std::min(block.size() - length, _read_size));
+                        if (n == 0) break;
+                        length += n;
+                    }
+
+                    if (length == CARRY_ROOM) break;
+
+                    block.resize(length);
+                    if (!_blocks.push(std::move(block))) return;
+                }
+
+                _blocks.finish();
+            }
+            catch (...) {
+                _blocks.finish(std::current_exception());
+            }
+        }
+
+        CSV_INLINE void ReadAheadParser::recycle_blocks() {
+            for (auto it = _parsed_blocks.begin(); it != _parsed_blocks.end();) {
+                // No CSVRow or chunk, and so no other thread, can still be using this block
+                if (it->use_count() == 1) {
+                    _blocks.recycle(std::move(**it));
+                    it = _parsed_blocks.erase(it);
+                }
+                else {
+                    ++it;
+                }
+            }
+        }
+
+        CSV_INLINE void ReadAheadParser::next(size_t bytes = ITERATION_CHUNK_SIZE) {
+            if (this->eof()) return;
+
+            _block_size.store(bytes, std::memory_order_relaxed);
+            this->recycle_blocks();
+
+            std::string block;
+            bool last = !_blocks.pop(block);
+            const csv::string_view carry = this->carry();
+
+            // Parse the block in place after copying the carried over row in front of it,
+            // unless that row is too long to keep chunks growing geometrically, as in next_chunk()
+            if (!last && carry.size() <= CARRY_ROOM && carry.size() <= block.size() - CARRY_ROOM) {
+                auto buffer = std::make_shared<std::string>(std::move(block));
+                const size_t begin = CARRY_ROOM - carry.size();
+                if (!carry.empty())
+                    std::memcpy(&(*buffer)[begin], carry.data(), carry.size());
+
+                _parsed_blocks.push_back(buffer);
+                this->parse_chunk(buffer, csv::string_view(buffer->data() + begin, buffer->size() - begin), false);
+                return;
+            }
+
+            // Otherwise, copy whole blocks after the carried over row until the chunk is large enough
+            size_t buffer_length;
+            auto buffer = this->begin_chunk(buffer_length);
+            const size_t target = buffer_length + std::max(bytes, buffer_length);
+
+            while (!last) {
+                append_chunk(*buffer, buffer_length, block.data() + CARRY_ROOM, block.size() - CARRY_ROOM);
+                _blocks.recycle(std::move(block));
+                if (buffer_length >= target)
+                    break;
+
+                last = !_blocks.pop(block);
+            }
+
+            this->parse_chunk(buffer, buffer_length, last);
+        }
+    }
+}
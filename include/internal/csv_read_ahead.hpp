@@ -0,0 +1,188 @@
+/** @file
+ *  @brief Parsers which read their input in blocks on a worker thread
+ */
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "basic_csv_parser.hpp"
+#include "common.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#define CSV_HAS_PREAD
+#endif
+
+namespace csv {
+    namespace internals {
+        /** A bounded queue of blocks passed from a producer thread
+         *  to a consumer thread
+         */
+        class BlockQueue {
+        public:
+            BlockQueue(size_t capacity) : _capacity(capacity ? capacity : 1) {}
+
+            /** Add a block, waiting while the queue is full
+             *
+             *  @returns False if the consumer has gone away
+             */
+            bool push(std::string&& block);
+
+            /** Remove a block, waiting while the queue is empty
+             *
+             *  @returns False once the producer has finished and all blocks were removed
+             *  @throws  Whatever the producer passed to finish()
+             */
+            bool pop(std::string& block);
+
+            /** Called by the consumer to hand a block it is done with back to the producer */
+            void recycle(std::string&& block);
+
+            /** Called by the producer to get a block passed to recycle(), or
+             *  an empty string if there are none
+             */
+            std::string take_recycled();
+
+            /** Called by the producer when it has no more blocks */
+            void finish(std::exception_ptr error = nullptr);
+
+            /** Called by the consumer when it will not remove any more blocks */
+            void cancel();
+
+        private:
+            std::mutex _lock;
+            std::condition_variable _not_full, _not_empty;
+            std::deque<std::string> _blocks, _recycled;
+            size_t _capacity;
+            bool _finished = false, _cancelled = false;
+            std::exception_ptr _error = nullptr;
+        };
+
+        /** Reads a source of CSV data incrementally */
+        class BlockReader {
+        public:
+            virtual ~BlockReader() {}
+
+            /** Read up to `length` bytes into `out`
+             *
+             *  @returns The number of bytes written, which is only 0 at the end of the input
+             *  @throws  std::runtime_error If the input could not be read
+             */
+            virtual size_t read(char* out, size_t length) = 0;
+        };
+
+        /** Reads an uncompressed file with pread() (or std::ifstream
+         *  where pread() is unavailable)
+         */
+        class FileReader : public BlockReader {
+        public:
+            /** @param[in] direct Bypass the page cache, if the platform and file system allow it */
+            FileReader(csv::string_view filename, bool direct = false);
+            ~FileReader();
+
+            FileReader(const FileReader&) = delete;
+            FileReader& operator=(const FileReader&) = delete;
+
+            size_t read(char* out, size_t length) override;
+
+        private:
+            std::string _filename;
+
+#ifdef CSV_HAS_PREAD
+            /** Size and alignment of O_DIRECT reads */
+            static constexpr size_t DIRECT_BLOCK_SIZE = 1 << 20;
+            static constexpr size_t DIRECT_ALIGNMENT = 4096;
+
+            int _fd = -1;
+            size_t _pos = 0;
+
+            /** Aligned buffer which O_DIRECT reads go through, or nullptr if
+             *  the page cache is not being bypassed
+             */
+            char* _direct_buffer = nullptr;
+            size_t _direct_pos = 0, _direct_size = 0;
+
+            /** Give up on O_DIRECT and go through the page cache */
+            void disable_direct();
+
+            size_t read_direct(char* out, size_t length);
+#else
+            std::ifstream _source;
+#endif
+        };
+
+        /** Parser which reads its input on a worker thread
+         *
+         *  @par Implementation
+         *  The worker fills blocks as large as the last chunk requested from a
+         *  BlockReader and passes them through a BlockQueue, so that reading and
+         *  parsing overlap while at most `depth` blocks are buffered. Each block
+         *  leaves room in front for the partial row at the end of the previous
+         *  chunk, so that it can be parsed in place. Blocks are recycled once no
+         *  CSVRow refers to them any more.
+         */
+        class ReadAheadParser : public IStreamParser {
+        public:
+            /** @param[in] read_size Most bytes passed to each BlockReader::read() */
+            ReadAheadParser(std::unique_ptr<BlockReader> reader,
+                size_t read_size,
+                size_t depth,
+                const CSVFormat& format,
+                const ColNamesPtr& col_names = nullptr
+            );
+
+            ~ReadAheadParser();
+
+            void next(size_t bytes) override;
+
+        private:
+            /** Room in front of every block for the partial row carried over from the previous chunk */
+            static constexpr size_t CARRY_ROOM = 1 << 16;
+
+            size_t _read_size;
+
+            /** Size of the blocks read from now on, after their CARRY_ROOM */
+            std::atomic<size_t> _block_size;
+
+            BlockQueue _blocks;
+            std::thread _worker;
+
+            /** Blocks which were parsed in place, and may still be referred to by rows */
+            std::deque<std::shared_ptr<std::string>> _parsed_blocks;
+
+            /** Run by _worker */
+            void read_blocks(std::unique_ptr<BlockReader> reader);
+
+            /** Hand blocks which no row refers to any more back to the worker */
+            void recycle_blocks();
+        };
+
+        /** Parser for uncompressed files which reads them with explicit reads
+         *  instead of memory mapping them
+         *
+         *  @see CSVFormat::read_with_pread()
+         */
+        class PreadParser : public ReadAheadParser {
+        public:
+            PreadParser(csv::string_view filename,
+                const CSVFormat& format,
+                const ColNamesPtr& col_names = nullptr
+            ) : ReadAheadParser(
+                std::unique_ptr<BlockReader>(new FileReader(filename, format.get_direct_io())), // For C++11
+                READ_SIZE, format.get_pread_depth(), format, col_names) {}
+
+        private:
+            /** Size of each read */
+            static constexpr size_t READ_SIZE = 1 << 22;
+        };
+    }
+}
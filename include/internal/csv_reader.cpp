@@ -19,6 +19,40 @@ namespace csv {
             return ret.str();
         }
 
+        CSV_INLINE RowAcceptor::RowAcceptor(const CSVFormat& format, const ColNamesPtr& col_names) :
+            _col_names(col_names),
+            _header(format.get_header()),
+            _policy(format.get_variable_column_policy()) {
+            const auto names = format.get_col_names();
+            if (names.empty())
+                return;
+
+            if (!format.has_column_selection()) {
+                this->set_col_names(names);
+                return;
+            }
+
+            std::vector<std::string> selected_names;
+            for (auto i : resolve_columns(names, format))
+                selected_names.push_back(names[i]);
+
+            this->set_col_names(selected_names);
+        }
+
+        CSV_INLINE void RowAcceptor::set_col_names(const std::vector<std::string>& names) {
+            this->_col_names->set_col_names(names);
+            this->_n_cols = names.size();
+        }
+
+        CSV_INLINE void RowAcceptor::reject(const CSVRow& row) const {
+            if (this->_policy == VariableColumnPolicy::THROW) {
+                if (row.size() < this->_n_cols)
+                    throw std::runtime_error("Line too short " + internals::format_row(row));
+
+                throw std::runtime_error("Line too long " + internals::format_row(row));
+            }
+        }
+
         /** Return a CSV's column names
          *
          *  @param[in] filename  Path to CSV file
@@ -28,12 +62,11 @@ namespace csv {
         CSV_INLINE std::vector<std::string> _get_col_names(csv::string_view head, CSVFormat format) {
             // Parse the CSV
             auto trim_chars = format.get_trim_chars();
-            std::stringstream source(head.data());
             RowCollection rows;
 
-            StreamParser<std::stringstream> parser(source, format);
+            StringViewParser parser(head, format);
             parser.set_output(rows);
-            parser.next();
+            parser.next(head.size());
 
             return CSVRow(std::move(rows[format.get_header()]));
         }
@@ -46,12 +79,11 @@ namespace csv {
             std::unordered_map<size_t, size_t> row_when = { { 0, 0 } };
 
             // Parse the CSV
-            std::stringstream source(head.data());
             RowCollection rows;
 
-            StreamParser<std::stringstream> parser(source, format);
+            StringViewParser parser(head, format);
             parser.set_output(rows);
-            parser.next();
+            parser.next(head.size());
 
             for (size_t i = 0; i < rows.size(); i++) {
                 auto& row = rows[i];
@@ -152,9 +184,72 @@ namespace csv {
      *
      */
 	CSV_INLINE CSVReader::CSVReader(csv::string_view filename, CSVFormat format) : _format(format) {
-        auto head = internals::get_csv_head(filename);
+        this->open_file(filename, format);
+        this->initial_read();
+    }
+
+    /** Reads a stream sequentially, without seeking
+     *
+     *  @par Example
+     *  @code
+     *  // zcat big.csv.gz | my_program
+     *  CSVReader reader(std::cin);
+     *  @endcode
+     */
+    CSV_INLINE CSVReader::CSVReader(std::istream& source, CSVFormat format) : _format(format) {
+        this->init_col_names(format);
+
+        this->parser = std::unique_ptr<internals::ForwardStreamParser>(
+            new internals::ForwardStreamParser(source, format, col_names)); // For C++11
+        this->initial_read();
+    }
+
+    /** Parses data which is already in memory without copying it
+     *
+     *  @param[in] data   CSV data, which must outlive every CSVRow read from it
+     *                    unless `owner` keeps it alive
+     *  @param[in] owner  Optional pointer which keeps `data` alive
+     *
+     *  @par Example
+     *  @code
+     *  CSVReader reader(csv::in_memory, message.payload(), format);
+     *  @endcode
+     */
+    CSV_INLINE CSVReader::CSVReader(InMemoryTag, csv::string_view data, CSVFormat format,
+        std::shared_ptr<void> owner) : _format(format) {
+        using Parser = internals::StringViewParser;
+
+        this->init_format(data.substr(0, internals::GUESS_HEAD_SIZE), format);
+
+        this->parser = std::unique_ptr<Parser>(
+            new Parser(data, format, this->col_names, std::move(owner))); // For C++11
+        this->initial_read();
+    }
+
+    CSV_INLINE void CSVReader::open_file(csv::string_view filename, CSVFormat format) {
         using Parser = internals::MmapParser;
 
+        // The head is only needed to guess the format
+        this->init_format(format.guess_delim() ? internals::get_csv_head(filename) : std::string(), format);
+
+        // gzip and zstd files are detected by their magic bytes
+        const auto compression = internals::detect_compression(filename);
+        if (compression != internals::Compression::NONE) {
+            this->parser = std::unique_ptr<internals::DecompressingParser>(
+                new internals::DecompressingParser(filename, compression, format, this->col_names)); // For C++11
+            return;
+        }
+
+        if (format.get_pread_depth() > 0) {
+            this->parser = std::unique_ptr<internals::PreadParser>(
+                new internals::PreadParser(filename, format, this->col_names)); // For C++11
+            return;
+        }
+
+        this->parser = std::unique_ptr<Parser>(new Parser(filename, format, this->col_names)); // For C++11
+    }
+
+    CSV_INLINE void CSVReader::init_format(csv::string_view head, CSVFormat& format) {
         /** Guess delimiter and header row */
         if (format.guess_delim()) {
             auto guess_result = internals::_guess_format(head, format.possible_delimiters);
@@ -163,11 +258,7 @@ namespace csv {
             this->_format = format;
         }
 
-        if (!format.col_names.empty())
-            this->set_col_names(format.col_names);
-
-        this->parser = std::unique_ptr<Parser>(new Parser(filename, format, this->col_names)); // For C++11
-        this->initial_read();
+        this->init_col_names(format);
     }
 
     /** Return the format of the original raw CSV */
@@ -204,18 +295,7 @@ namespace csv {
     }
 
     CSV_INLINE void CSVReader::trim_header() {
-        if (!this->header_trimmed) {
-            for (int i = 0; i <= this->_format.header && !this->records->empty(); i++) {
-                if (i == this->_format.header && this->col_names->empty()) {
-                    this->set_col_names(this->records->pop_front());
-                }
-                else {
-                    this->records->pop_front();
-                }
-            }
-
-            this->header_trimmed = true;
-        }
+        this->acceptor.trim_header(*this->records);
     }
 
     /**
@@ -223,34 +303,131 @@ namespace csv {
      */
     CSV_INLINE void CSVReader::set_col_names(const std::vector<std::string>& names)
     {
-        this->col_names->set_col_names(names);
-        this->n_cols = names.size();
+        this->acceptor.set_col_names(names);
+    }
+
+    CSV_INLINE void CSVReader::init_col_names(const CSVFormat& format) {
+        this->acceptor = internals::RowAcceptor(format, this->col_names);
     }
 
     /**
      * Read a chunk of CSV data.
      *
-     * @note This method is meant to be run on its own thread. Only one `read_csv()` thread
-     *       should be active at a time.
+     * @note Only one `read_csv()` or read_ahead() call should be active at a time.
      *
      * @param[in] bytes Number of bytes to read.
      *
-     * @see CSVReader::read_csv_worker
      * @see CSVReader::read_row()
      */
     CSV_INLINE bool CSVReader::read_csv(size_t bytes) {
         // Tell read_row() to listen for CSV rows
         this->records->notify_all();
 
+        this->read_chunk(bytes);
+
+        // Tell read_row() to stop waiting
+        this->records->kill_all();
+
+        return true;
+    }
+
+    CSV_INLINE void CSVReader::read_chunk(size_t bytes) {
         this->parser->set_output(*this->records);
-        this->parser->next(bytes);
 
-        if (!this->header_trimmed) {
+        const size_t rows_before = this->parser->rows_pushed(),
+            fields_before = this->parser->fields_pushed();
+
+        try {
+            this->parser->next(bytes);
+        }
+        catch (...) {
+            this->read_csv_exception = std::current_exception();
+        }
+
+        this->records->flush();
+
+        // The rows of this chunk were only just published, so the consumer is keeping up
+        // if at most half a chunk of rows from earlier chunks is still unread
+        const size_t rows = this->parser->rows_pushed() - rows_before;
+        this->_chunk_sizer.update(bytes, rows,
+            this->parser->fields_pushed() - fields_before, this->records->size() <= rows + rows / 2);
+
+        if (!this->acceptor.header_trimmed()) {
             this->trim_header();
         }
+    }
+
+    CSV_INLINE void CSVReader::read_ahead() {
+        const size_t depth = this->_format.get_read_ahead();
+        auto& chunk_ends = this->read_ahead_chunk_ends;
+
+        try {
+            while (!this->parser->eof() && !this->read_csv_exception && !this->records->cancelled()) {
+                while (!chunk_ends.empty() && chunk_ends.front() <= this->records->n_taken())
+                    chunk_ends.pop_front();
+
+                if (chunk_ends.size() >= depth) {
+                    // Give the thread back to the executor until the oldest chunk was read
+                    if (this->records->resume_when_taken(chunk_ends.front(), [this]() { this->submit_read_ahead(); }))
+                        return;
+
+                    continue;
+                }
+
+                this->read_chunk(this->_chunk_sizer.size());
+                chunk_ends.push_back(this->records->n_published());
+            }
+        }
+        catch (...) {
+            this->read_csv_exception = std::current_exception();
+        }
 
         // Tell read_row() to stop waiting
         this->records->kill_all();
+    }
+
+    CSV_INLINE void CSVReader::submit_read_ahead() {
+        this->_format.get_executor().submit(*this->read_ahead_tasks, [this]() { this->read_ahead(); });
+    }
+
+    CSV_INLINE void CSVReader::start_read_ahead() {
+        // Parsing ahead is started by the first read, rather than by the constructor,
+        // so that readers can still be moved until then
+        if (!this->read_ahead_started && !this->parser->eof() && !this->read_csv_exception) {
+            this->records->notify_all();
+            this->submit_read_ahead();
+            this->read_ahead_started = true;
+        }
+    }
+
+    CSV_INLINE bool CSVReader::wait_for_row() {
+        this->start_read_ahead();
+
+        while (this->records->empty()) {
+            if (this->records->is_waitable()) {
+                // If no thread of the executor got to parsing ahead yet, e.g. because this is
+                // the only one, do it here rather than wait for it
+                if (this->_format.get_executor().run_pending(*this->read_ahead_tasks))
+                    continue;
+
+                // Reading thread is currently active => wait for it to populate records
+                this->records->wait();
+                continue;
+            }
+
+            // Reading thread is done, after pushing its last rows
+            if (!this->records->empty())
+                return true;
+
+            if (this->read_csv_exception) {
+                // Reading thread failed => report the error once all rows before it are consumed
+                this->_format.get_executor().wait(*this->read_ahead_tasks);
+
+                this->rethrow_read_csv_exception();
+            }
+
+            return false;
+        }
 
         return true;
     }
@@ -259,7 +436,7 @@ namespace csv {
      * Retrieve rows as CSVRow objects, returning true if more rows are available.
      *
      * @par Performance Notes
-     *  - Reads chunks of data that are csv::internals::ITERATION_CHUNK_SIZE bytes large at a time
+     *  - Reads chunks of data that are chunk_size() bytes large at a time
      *  - For performance details, read the documentation for CSVRow and CSVField.
      *
      * @param[out] row The variable where the parsed row will be stored
@@ -270,32 +447,9 @@ namespace csv {
      *
      */
     CSV_INLINE bool CSVReader::read_row(CSVRow &row) {
-        while (true) {
-            if (this->records->empty()) {
-                if (this->records->is_waitable())
-                    // Reading thread is currently active => wait for it to populate records
-                    this->records->wait();
-                else if (this->parser->eof())
-                    // End of file and no more records
-                    return false;
-                else {
-                    // Reading thread is not active => start another one
-                    if (this->read_csv_worker.joinable())
-                        this->read_csv_worker.join();
-
-                    this->read_csv_worker = std::thread(&CSVReader::read_csv, this, internals::ITERATION_CHUNK_SIZE);
-                }
-            }
-            else if (this->records->front().size() != this->n_cols &&
-                this->_format.variable_column_policy != VariableColumnPolicy::KEEP) {
-                auto errored_row = this->records->pop_front();
-
-                if (this->_format.variable_column_policy == VariableColumnPolicy::THROW) {
-                    if (errored_row.size() < this->n_cols)
-                        throw std::runtime_error("Line too short " + internals::format_row(errored_row));
-
-                    throw std::runtime_error("Line too long " + internals::format_row(errored_row));
-                }
+        while (this->wait_for_row()) {
+            if (!this->acceptor.accepts(this->records->front())) {
+                this->acceptor.reject(this->records->pop_front());
             }
             else {
                 row = this->records->pop_front();
@@ -306,4 +460,65 @@ namespace csv {
 
         return false;
     }
+
+    /**
+     * Retrieve up to `max_rows` rows at once, returning true if any rows were read.
+     *
+     * @par Performance Notes
+     *  Compared to calling read_row() for every row, this only waits for the parsing
+     *  thread once per batch, and `batch` reuses its storage when it is refilled. A
+     *  batch stops at the end of a chunk, so it may have fewer than `max_rows` rows
+     *  even before the end of the CSV.
+     *
+     * @param[out] batch    Replaced by the rows which were read
+     * @param[in]  max_rows Maximum number of rows to read
+     *
+     * @par Example
+     * @code
+     * RowBatch batch;
+     * while (reader.read_rows(batch, 1000)) {
+     *     for (auto& row : batch) { ... }
+     * }
+     * @endcode
+     */
+    CSV_INLINE bool CSVReader::read_rows(RowBatch& batch, size_t max_rows) {
+        this->fill_batch(batch, max_rows, true);
+        return !batch.rows.empty();
+    }
+
+    CSV_INLINE bool CSVReader::fill_batch(RowBatch& batch, size_t max_rows, bool wait) {
+        auto& rows = batch.rows;
+        rows.clear();
+
+        while (rows.empty() && max_rows > 0) {
+            if (!wait && !this->batch_ready())
+                return false;
+
+            if (!this->wait_for_row())
+                break;
+
+            const internals::RawCSVData* chunk = this->records->front().data.get();
+
+            // Only take rows which have already been parsed
+            while (rows.size() < max_rows && !this->records->empty()) {
+                auto& row = this->records->front();
+                if (row.data.get() != chunk)
+                    break;
+
+                if (!this->acceptor.accepts(row)) {
+                    // Return the rows before the error first, like read_row()
+                    if (this->acceptor.is_error(row) && !rows.empty())
+                        break;
+
+                    this->acceptor.reject(this->records->pop_front());
+                }
+                else {
+                    rows.push_back(this->records->pop_front());
+                }
+            }
+        }
+
+        this->_n_rows += rows.size();
+        return true;
+    }
 }
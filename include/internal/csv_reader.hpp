@@ -6,8 +6,11 @@
 
 #include <algorithm>
 #include <deque>
+#include <exception>
 #include <fstream>
+#include <functional>
 #include <iterator>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <thread>
@@ -18,15 +21,82 @@
 #include "../external/mio.hpp"
 #include "basic_csv_parser.hpp"
 #include "common.hpp"
+#include "csv_chunk_size.hpp"
+#include "csv_decompress.hpp"
+#include "csv_executor.hpp"
+#include "csv_read_ahead.hpp"
 #include "data_type.hpp"
 #include "csv_format.hpp"
 
+#ifdef CSV_HAS_COROUTINES
+#include <coroutine>
+#endif
+
 /** The all encompassing namespace */
 namespace csv {
     /** Stuff that is generally not of interest to end-users */
     namespace internals {
         std::string format_row(const std::vector<std::string>& row, csv::string_view delim = ", ");
 
+        /** Applies the header row and variable column policy of a CSVFormat to parsed
+         *  rows, so that CSVReader and CSVPushParser return the same rows
+         */
+        class RowAcceptor {
+        public:
+            RowAcceptor() = default;
+
+            /** Use the column names given by `format`, if any, keeping only those of selected columns */
+            RowAcceptor(const CSVFormat& format, const ColNamesPtr& col_names);
+
+            /** The number of columns in the CSV, or 0 if it is not known yet */
+            size_t n_cols() const noexcept { return this->_n_cols; }
+
+            /** Set the column names, which every row is expected to match */
+            void set_col_names(const std::vector<std::string>& names);
+
+            /** Drop rows up to and including the header from the front of `records`,
+             *  using the header as column names unless they were already set
+             */
+            template<typename TQueue>
+            void trim_header(TQueue& records) {
+                while (this->_header_rows <= this->_header && !records.empty()) {
+                    // The parser may have already filled in col_names for row filters
+                    if (this->_header_rows == this->_header && this->_n_cols == 0)
+                        this->set_col_names(records.pop_front());
+                    else
+                        records.pop_front();
+
+                    this->_header_rows++;
+                }
+            }
+
+            /** Whether or not rows before and including the header were dropped */
+            bool header_trimmed() const noexcept { return this->_header_rows > this->_header; }
+
+            /** Whether or not a row after the header should be returned */
+            bool accepts(const CSVRow& row) const noexcept {
+                return row.size() == this->_n_cols || this->_policy == VariableColumnPolicy::KEEP;
+            }
+
+            /** Whether or not reject() would throw for `row` */
+            bool is_error(const CSVRow& row) const noexcept {
+                return !this->accepts(row) && this->_policy == VariableColumnPolicy::THROW;
+            }
+
+            /** Called with a row which was not accepted, which is dropped
+             *
+             *  @throws std::runtime_error If the variable column policy is THROW
+             */
+            void reject(const CSVRow& row) const;
+
+        private:
+            ColNamesPtr _col_names = nullptr;
+            int _header = 0;
+            VariableColumnPolicy _policy = VariableColumnPolicy::IGNORE_ROW;
+            size_t _n_cols = 0;
+            int _header_rows = 0;
+        };
+
         std::vector<std::string> _get_col_names( csv::string_view head, const CSVFormat format = CSVFormat::guess_csv());
 
         struct GuessScore {
@@ -47,6 +117,14 @@ namespace csv {
     CSVGuessResult guess_format(csv::string_view filename,
         const std::vector<char>& delims = { ',', '|', '\t', ';', '^', '~' });
 
+    /** Tag type selecting the CSVReader constructor which parses in-memory data in place */
+    struct InMemoryTag {};
+
+    /** @see InMemoryTag */
+    constexpr InMemoryTag in_memory = InMemoryTag();
+
+    class MultiCSVReader;
+
     /** @class CSVReader
      *  @brief Main class for parsing CSVs from files and in-memory sources
      *
@@ -120,28 +198,89 @@ namespace csv {
         CSVReader(TStream& source, CSVFormat format = CSVFormat()) : _format(format) {
             using Parser = internals::StreamParser<TStream>;
 
-            if (!format.col_names.empty())
-                this->set_col_names(format.col_names);
+            this->init_col_names(format);
 
             this->parser = std::unique_ptr<Parser>(
                 new Parser(source, format, col_names)); // For C++11
             this->initial_read();
         }
+
+        /** Allows parsing streams which cannot seek, such as pipes, sockets and `std::cin`
+         *
+         *  @note Like streams which can seek, this constructor requires special CSV dialects
+         *        to be manually specified.
+         */
+        CSVReader(std::istream& source, CSVFormat format = CSVFormat());
+
+        CSVReader(InMemoryTag, csv::string_view data, CSVFormat format = CSVFormat(),
+            std::shared_ptr<void> owner = nullptr);
+
+        /** Reads a CSV file with a parser specialized for a dialect known at compile time
+         *
+         *  @see StaticCSVFormat
+         */
+        template<char Delim, char Quote, bool UseQuote>
+        CSVReader(csv::string_view filename, const StaticCSVFormat<Delim, Quote, UseQuote>& format) : _format(format) {
+            this->open_file(filename, format);
+            this->use_static_dialect(format);
+            this->initial_read();
+        }
+
+        /** Reads a stream with a parser specialized for a dialect known at compile time
+         *
+         *  @see StaticCSVFormat
+         */
+        template<typename TStream, char Delim, char Quote, bool UseQuote,
+            csv::enable_if_t<std::is_base_of<std::istream, TStream>::value, int> = 0>
+        CSVReader(TStream& source, const StaticCSVFormat<Delim, Quote, UseQuote>& format) : _format(format) {
+            using Parser = internals::StreamParser<TStream>;
+
+            this->init_col_names(format);
+
+            this->parser = std::unique_ptr<Parser>(
+                new Parser(source, format, col_names)); // For C++11
+            this->use_static_dialect(format);
+            this->initial_read();
+        }
+
+        /** Reads a stream which cannot seek with a parser specialized for a dialect
+         *  known at compile time
+         *
+         *  @see StaticCSVFormat
+         */
+        template<char Delim, char Quote, bool UseQuote>
+        CSVReader(std::istream& source, const StaticCSVFormat<Delim, Quote, UseQuote>& format) : _format(format) {
+            this->init_col_names(format);
+
+            this->parser = std::unique_ptr<internals::ForwardStreamParser>(
+                new internals::ForwardStreamParser(source, format, col_names)); // For C++11
+            this->use_static_dialect(format);
+            this->initial_read();
+        }
         ///@}
 
+        /** @note Readers must not be moved once rows have been read from them,
+         *        because the tasks parsing ahead refer to the original reader
+         */
         CSVReader(const CSVReader&) = delete; // No copy constructor
         CSVReader(CSVReader&&) = default;     // Move constructor
         CSVReader& operator=(const CSVReader&) = delete; // No copy assignment
         CSVReader& operator=(CSVReader&& other) = default;
         ~CSVReader() {
-            if (this->read_csv_worker.joinable()) {
-                this->read_csv_worker.join();
+            // Stop parsing ahead
+            if (this->records)
+                this->records->cancel();
+
+            if (this->read_ahead_tasks) {
+                try { this->_format.get_executor().wait(*this->read_ahead_tasks); }
+                catch (...) {}
             }
         }
 
         /** @name Retrieving CSV Rows */
         ///@{
         bool read_row(CSVRow &row);
+        bool read_rows(RowBatch& batch, size_t max_rows);
         iterator begin();
         HEDLEY_CONST iterator end() const noexcept;
 
@@ -149,11 +288,207 @@ namespace csv {
         bool eof() const noexcept { return this->parser->eof(); };
         ///@}
 
+#ifdef CSV_HAS_COROUTINES
+        /** @name Reading Rows from Coroutines */
+        ///@{
+        /** Called with a coroutine which is ready to be resumed */
+        using Resumer = std::function<void(std::coroutine_handle<>)>;
+
+        /** The awaitable returned by next_batch() */
+        class BatchAwaiter {
+        public:
+            bool await_ready() { return this->try_fill(); }
+
+            bool await_suspend(std::coroutine_handle<> handle) {
+                this->handle = handle;
+                return this->wait_for_batch();
+            }
+
+            RowBatch await_resume() {
+                if (this->error)
+                    std::rethrow_exception(this->error);
+
+                return std::move(this->batch);
+            }
+
+        private:
+            friend CSVReader;
+
+            BatchAwaiter(CSVReader& reader, size_t max_rows, Resumer resume) :
+                reader(reader), max_rows(max_rows), resume(std::move(resume)) {}
+
+            CSVReader& reader;
+            size_t max_rows;
+            Resumer resume;
+            std::coroutine_handle<> handle = nullptr;
+            RowBatch batch;
+            std::exception_ptr error = nullptr;
+
+            /** Fill the batch if that does not require waiting for rows to be parsed
+             *
+             *  @returns Whether the batch, which is empty at the end of the CSV, or an error is ready
+             */
+            bool try_fill() {
+                try {
+                    return this->reader.fill_batch(this->batch, this->max_rows, false);
+                }
+                catch (...) {
+                    this->error = std::current_exception();
+                    return true;
+                }
+            }
+
+            /** Have the reader call back once more rows were parsed, unless a batch is ready
+             *
+             *  @returns False if the batch is ready, so the coroutine does not need to wait
+             */
+            bool wait_for_batch() {
+                // Every row which is available may be dropped by the variable
+                // column policy, in which case the coroutine keeps waiting
+                while (true) {
+                    if (this->reader.resume_when_ready([this]() { this->on_rows_parsed(); }))
+                        return true;
+
+                    if (this->try_fill())
+                        return false;
+                }
+            }
+
+            /** Called by the task parsing ahead, which should neither take rows nor run the coroutine itself */
+            void on_rows_parsed() {
+                this->reader._format.get_executor().post([this]() {
+                    if (this->wait_for_batch())
+                        return;
+
+                    if (this->resume)
+                        this->resume(this->handle);
+                    else
+                        this->handle.resume();
+                });
+            }
+        };
+
+        /** Read up to `max_rows` rows, suspending the calling coroutine rather than
+         *  blocking its thread while they are parsed
+         *
+         *  `co_await reader.next_batch()` returns a RowBatch, which is empty at the end of the CSV.
+         *  Like read_rows(), a batch stops at the end of a chunk, and errors from parsing
+         *  are thrown once the rows before them have been read.
+         *
+         *  @param[in] max_rows Maximum number of rows to read
+         *  @param[in] resume   Called on a thread of the reader's Executor once the batch is ready,
+         *                      which should schedule the coroutine on e.g. an event loop rather
+         *                      than resume it directly. By default, the coroutine is resumed by a
+         *                      task on the reader's Executor.
+         *
+         *  @note The coroutine is not resumed for rows dropped under the variable column policy,
+         *        so resuming it never waits for rows to be parsed
+         *
+         *  @par Example
+         *  @code
+         *  while (true) {
+         *      RowBatch batch = co_await reader.next_batch(1000);
+         *      if (batch.empty()) break;
+         *
+         *      for (auto& row : batch) { ... }
+         *  }
+         *  @endcode
+         */
+        BatchAwaiter next_batch(size_t max_rows = internals::RowBatchQueue::BATCH_SIZE, Resumer resume = nullptr) {
+            return BatchAwaiter(*this, max_rows, std::move(resume));
+        }
+        ///@}
+#endif
+
+        /** @name Processing Rows in Parallel */
+        ///@{
+        /** Call `fn(row)` for every remaining row on the threads of this reader's Executor
+         *
+         *  Rows are handed out in batches, and idle threads steal batches queued for
+         *  busy ones, so uneven per-row costs are balanced out. Parsing continues
+         *  while the rows are processed.
+         *
+         *  @param[in] fn        Called with a `const CSVRow&`. Calls are concurrent and in no
+         *                       particular order, so `fn` must be thread-safe.
+         *  @param[in] n_threads Call `fn` on this many threads started just for this call
+         *                       instead (0 to use the reader's Executor)
+         *
+         *  @see CSVFormat::executor()
+         *
+         *  @throws The first exception thrown by `fn` or by parsing, after all
+         *          running calls to `fn` have returned
+         */
+        template<typename Function>
+        void parallel_for_each(Function fn, size_t n_threads = 0) {
+            this->parallel_batches([&fn](const RowBatch& batch, size_t) {
+                for (auto& row : batch)
+                    fn(row);
+            }, n_threads);
+        }
+
+        /** Combine `map(row)` of every remaining row with `reduce`, using the threads of this reader's Executor
+         *
+         *  Each batch of rows is reduced on its own, starting from `identity`, and the
+         *  results of the batches are then reduced into the final result.
+         *
+         *  @param[in] map       Called with a `const CSVRow&`, concurrently
+         *  @param[in] reduce    Called with two values of type `T`, and returns their combination.
+         *                       Calls are concurrent, except for the ones combining batch results.
+         *  @param[in] identity  Value for which `reduce(identity, x) == x`
+         *  @param[in] n_threads Call `map` and `reduce` on this many threads started just for
+         *                       this call instead (0 to use the reader's Executor)
+         *  @param[in] ordered   Combine values in the order of their rows, so that `reduce`
+         *                       only needs to be associative rather than also commutative
+         *
+         *  @par Example
+         *  @code
+         *  // Sum of the "Price" column
+         *  double total = reader.parallel_map_reduce(
+         *      [](const CSVRow& row) { return row["Price"].get<double>(); },
+         *      [](double a, double b) { return a + b; },
+         *      0.0);
+         *  @endcode
+         */
+        template<typename T, typename Map, typename Reduce>
+        T parallel_map_reduce(Map map, Reduce reduce, T identity, size_t n_threads = 0, bool ordered = false) {
+            std::mutex lock;
+            T result = identity;
+
+            // Batch results which cannot be combined yet because an earlier one is missing
+            std::map<size_t, T> done;
+            size_t next = 0;
+
+            this->parallel_batches([&](const RowBatch& batch, size_t i) {
+                T partial = identity;
+                for (auto& row : batch)
+                    partial = reduce(std::move(partial), map(row));
+
+                std::lock_guard<std::mutex> guard(lock);
+                if (!ordered) {
+                    result = reduce(std::move(result), std::move(partial));
+                    return;
+                }
+
+                done.emplace(i, std::move(partial));
+                for (auto it = done.begin(); it != done.end() && it->first == next; it = done.erase(it), next++)
+                    result = reduce(std::move(result), std::move(it->second));
+            }, n_threads);
+
+            return result;
+        }
+        ///@}
+
         /** @name CSV Metadata */
         ///@{
         CSVFormat get_format() const;
         std::vector<std::string> get_col_names() const;
         int index_of(csv::string_view col_name) const;
+
+        /** How many bytes the next chunk of the CSV will be parsed in
+         *
+         *  @see CSVFormat::chunk_size(), CSVFormat::adaptive_chunk_size()
+         */
+        size_t chunk_size() const noexcept { return this->_chunk_sizer.size(); }
         ///@}
 
         /** @name CSV Metadata: Attributes */
@@ -184,6 +519,11 @@ namespace csv {
         /** Sets this reader's column names and associated data */
         void set_col_names(const std::vector<std::string>&);
 
+        /** Sets this reader's column names to the selected
+         *  subset of the names given by `format`, if any
+         */
+        void init_col_names(const CSVFormat& format);
+
         /** @name CSV Settings **/
         ///@{
         CSVFormat _format;
@@ -198,31 +538,158 @@ namespace csv {
         std::unique_ptr<internals::IBasicCSVParser> parser = nullptr;
 
         /** Queue of parsed CSV rows */
-        std::unique_ptr<RowCollection> records{new RowCollection(100)};
+        std::unique_ptr<internals::RowBatchQueue> records{new internals::RowBatchQueue()};
+
+        /** Chooses how many bytes read_csv() parses at a time */
+        internals::ChunkSizer _chunk_sizer;
+
+        /** Decides which parsed rows are returned */
+        internals::RowAcceptor acceptor;
 
-        size_t n_cols = 0;  /**< The number of columns in this CSV */
         size_t _n_rows = 0; /**< How many rows (minus header) have been read so far */
 
         /** @name Multi-Threaded File Reading Functions */
         ///@{
         bool read_csv(size_t bytes = internals::ITERATION_CHUNK_SIZE);
+
+        /** Parse one chunk into `records` */
+        void read_chunk(size_t bytes);
+
+        /** Parse chunks until the end of the CSV or until CSVFormat::get_read_ahead()
+         *  chunks were not read yet, in which case it is resubmitted once read_row()
+         *  catches up
+         *
+         *  @note Runs as a task on the reader's Executor, so that it does not hold on
+         *        to a thread while the consumer is behind
+         */
+        void read_ahead();
+
+        /** Queue read_ahead() on the reader's Executor */
+        void submit_read_ahead();
         ///@}
 
         /**@}*/
 
     private:
-        /** Whether or not rows before header were trimmed */
-        bool header_trimmed = false;
+        friend MultiCSVReader;
 
         /** @name Multi-Threaded File Reading: Flags and State */
         ///@{
-        std::thread read_csv_worker; /**< Worker thread for read_csv() */
+        /** Tracks the read_ahead() task, of which at most one is queued or running */
+        std::unique_ptr<TaskGroup> read_ahead_tasks = std::unique_ptr<TaskGroup>(new TaskGroup()); // For C++11
+
+        /** How many rows had been published at the end of each chunk which was not taken yet */
+        std::deque<size_t> read_ahead_chunk_ends;
+
+        /** Whether read_ahead() was started */
+        bool read_ahead_started = false;
+
+        /** Exception thrown by the last read_csv() call, which is rethrown by read_row() */
+        std::exception_ptr read_csv_exception = nullptr;
         ///@}
 
+        /** Guess the format of a CSV file (if necessary) and create a parser for it */
+        void open_file(csv::string_view filename, CSVFormat format);
+
+        /** Guess the delimiter and header row from `head` (if necessary) and set up column names */
+        void init_format(csv::string_view head, CSVFormat& format);
+
+        /** Switch the parser to the state machine for `format` if its settings
+         *  still match its template arguments
+         */
+        template<char Delim, char Quote, bool UseQuote>
+        void use_static_dialect(const StaticCSVFormat<Delim, Quote, UseQuote>& format) {
+            if (format.is_static_dialect())
+                this->parser->use_static_dialect<Delim, Quote, UseQuote>();
+        }
+
         /** Read initial chunk to get metadata */
         void initial_read() {
-            this->read_csv_worker = std::thread(&CSVReader::read_csv, this, internals::ITERATION_CHUNK_SIZE);
-            this->read_csv_worker.join();
+            this->_chunk_sizer = internals::ChunkSizer(this->_format);
+
+            // Besides the chunks parsed ahead, rows of the chunk being read are still in memory
+            this->_chunk_sizer.set_chunks_in_flight(this->_format.get_read_ahead() + 1);
+
+            // Chunks may be smaller than the header, which has to be known before rows are handed out
+            do {
+                this->read_csv(this->_chunk_sizer.size());
+            } while (!this->acceptor.header_trimmed() && !this->parser->eof() && !this->read_csv_exception);
+
+            // Errors after the header are reported by read_row() once the rows before them are consumed
+            if (this->acceptor.n_cols() == 0)
+                this->rethrow_read_csv_exception();
+        }
+
+        /** Number of rows in each batch handed to a worker by parallel_batches() */
+        static constexpr size_t PARALLEL_BATCH_SIZE = 256;
+
+        /** Call `fn(batch, i)` for the `i`th batch of the remaining rows on the reader's Executor,
+         *  or on `n_threads` threads of a new one
+         */
+        template<typename Function>
+        void parallel_batches(Function fn, size_t n_threads) {
+            std::unique_ptr<Executor> own_executor(n_threads ? new Executor(n_threads) : nullptr);
+            Executor& executor = own_executor ? *own_executor : this->_format.get_executor();
+            TaskGroup group;
+
+            try {
+                // Keep a few batches per thread queued, so that threads have something to steal
+                // without reading the whole CSV into memory
+                for (size_t i = 0; !group.failed(); i++) {
+                    auto batch = std::make_shared<RowBatch>();
+                    if (!this->read_rows(*batch, PARALLEL_BATCH_SIZE))
+                        break;
+
+                    executor.submit(group, [&fn, batch, i]() { fn(*batch, i); }, 4 * executor.size());
+                }
+            }
+            catch (...) {
+                // Tasks refer to `fn`, so they have to be finished before it goes away
+                try { executor.wait(group); }
+                catch (...) {}
+                throw;
+            }
+
+            executor.wait(group);
+        }
+
+        /** Start read_ahead() if it was not started yet */
+        void start_read_ahead();
+
+        /** Like read_rows(), but unless `wait` is set, stop instead of waiting for rows to be parsed
+         *
+         *  @returns False if it stopped before reading any rows or reaching the end of the CSV
+         */
+        bool fill_batch(RowBatch& batch, size_t max_rows, bool wait);
+
+        /** Whether wait_for_row() would return without waiting for rows to be parsed */
+        bool batch_ready() {
+            this->start_read_ahead();
+            return !this->records->empty() || !this->records->is_waitable();
+        }
+
+        /** Have the task parsing ahead call `resume()` once batch_ready() becomes true
+         *
+         *  @returns False if it already is, in which case `resume()` is never called
+         */
+        bool resume_when_ready(std::function<void()> resume) {
+            return this->records->resume_when_available(std::move(resume));
+        }
+
+        /** Wait until a row is available in `records`, starting read_ahead() if necessary
+         *
+         *  @returns False at the end of the CSV
+         *  @throws  Errors from parsing, once the rows before them have been read
+         */
+        bool wait_for_row();
+
+        /** Rethrow any exception thrown by read_csv() on the calling thread */
+        void rethrow_read_csv_exception() {
+            if (this->read_csv_exception) {
+                auto error = this->read_csv_exception;
+                this->read_csv_exception = nullptr;
+                std::rethrow_exception(error);
+            }
         }
 
         void trim_header();
@@ -7,13 +7,8 @@
 namespace csv {
     /** Return an iterator to the first row in the reader */
     CSV_INLINE CSVReader::iterator CSVReader::begin() {
-        if (this->records->empty()) {
-            this->read_csv_worker = std::thread(&CSVReader::read_csv, this, internals::ITERATION_CHUNK_SIZE);
-            this->read_csv_worker.join();
-
-            // Still empty => return end iterator
-            if (this->records->empty()) return this->end();
-        }
+        // No more rows => return end iterator
+        if (!this->wait_for_row()) return this->end();
 
         this->_n_rows++;
         CSVReader::iterator ret(this, this->records->pop_front());
@@ -71,13 +71,13 @@ namespace csv {
 
         const size_t field_index = this->fields_start + index;
         auto& field = this->data->fields[field_index];
-        auto field_str = csv::string_view(this->data->data).substr(this->data_start + field.start);
+        const csv::string_view field_str(this->data->data.data() + this->data_start + field.start, field.length);
 
         if (field.has_double_quote) {
             auto& value = this->data->double_quote_fields[field_index];
             if (value.empty()) {
                 bool prev_ch_quote = false;
-                for (size_t i = 0; i < field.length; i++) {
+                for (size_t i = 0; i < field_str.size(); i++) {
                     if (this->data->parse_flags[field_str[i] + 128] == ParseFlags::QUOTE) {
                         if (prev_ch_quote) {
                             prev_ch_quote = false;
@@ -95,7 +95,7 @@ namespace csv {
             return csv::string_view(value);
         }
 
-        return field_str.substr(0, field.length);
+        return field_str;
     }
 
     CSV_INLINE bool CSVField::try_parse_hex(int& parsedValue) {
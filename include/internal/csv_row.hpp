@@ -4,6 +4,7 @@
 
 #pragma once
 #include <cmath>
+#include <cstdint>
 #include <deque>
 #include <iterator>
 #include <memory> // For CSVField
@@ -12,6 +13,7 @@
 #include <unordered_set>
 #include <string>
 #include <sstream>
+#include <stdexcept>
 #include <vector>
 
 #include "common.hpp"
@@ -19,6 +21,9 @@
 #include "col_names.hpp"
 
 namespace csv {
+    class CSVReader;
+    class MultiCSVReader;
+
     namespace internals {
         class IBasicCSVParser;
 
@@ -30,25 +35,45 @@ namespace csv {
     
         std::string json_escape_string(csv::string_view s) noexcept;
 
-        /** A barebones class used for describing CSV fields */
+        /** A barebones class used for describing CSV fields
+         *
+         *  @par Implementation
+         *  Fields are packed into 8 bytes, because for wide files the field list of
+         *  a chunk is often larger than its text. Since field positions are relative
+         *  to their row, this only limits the size of individual rows and fields.
+         */
         struct RawCSVField {
+            /** Largest start which can be stored */
+            static constexpr size_t MAX_START = UINT32_MAX;
+
+            /** Largest length which can be stored */
+            static constexpr size_t MAX_LENGTH = UINT32_MAX >> 1;
+
             RawCSVField() = default;
+
+            /** @throws std::runtime_error if `_start` or `_length` do not fit */
             RawCSVField(size_t _start, size_t _length, bool _double_quote = false) {
-                start = _start;
-                length = _length;
+                if (_start > MAX_START || _length > MAX_LENGTH)
+                    throw std::runtime_error("Fields must start within 4 GB of the beginning "
+                        "of their row and be shorter than 2 GB.");
+
+                start = (uint32_t)_start;
+                length = (uint32_t)(_length & MAX_LENGTH);
                 has_double_quote = _double_quote;
             }
 
             /** The start of the field, relative to the beginning of the row */
-            size_t start;
+            uint32_t start;
 
             /** The length of the row, ignoring quote escape characters */
-            size_t length; 
+            uint32_t length : 31;
 
             /** Whether or not the field contains an escaped quote */
-            bool has_double_quote;
+            uint32_t has_double_quote : 1;
         };
 
+        STATIC_ASSERT(sizeof(RawCSVField) == 8);
+
         /** A class used for efficiently storing RawCSVField objects and expanding as necessary
          *
          *  @par Implementation
@@ -310,6 +335,7 @@ namespace csv {
     class CSVRow {
     public:
         friend internals::IBasicCSVParser;
+        friend CSVReader;
 
         CSVRow() = default;
         
@@ -413,6 +439,42 @@ namespace csv {
         size_t row_length = 0;
     };
 
+    /** A reusable batch of rows filled by CSVReader::read_rows()
+     *
+     *  All rows of a batch come from the same chunk of the CSV, i.e. they
+     *  share the same underlying data. The rows are only released once the
+     *  batch is refilled or destroyed.
+     */
+    class RowBatch {
+    public:
+        using const_iterator = std::vector<CSVRow>::const_iterator;
+
+        RowBatch() = default;
+
+        /** @param[in] capacity Number of rows to reserve space for */
+        RowBatch(size_t capacity) { this->rows.reserve(capacity); }
+
+        /** Number of rows in the batch */
+        size_t size() const noexcept { return this->rows.size(); }
+
+        /** Whether or not the batch has no rows */
+        bool empty() const noexcept { return this->rows.empty(); }
+
+        const CSVRow& operator[](size_t n) const noexcept { return this->rows[n]; }
+
+        const_iterator begin() const noexcept { return this->rows.begin(); }
+        const_iterator end() const noexcept { return this->rows.end(); }
+
+        /** Release all rows */
+        void clear() noexcept { this->rows.clear(); }
+
+    private:
+        friend CSVReader;
+        friend MultiCSVReader;
+
+        std::vector<CSVRow> rows;
+    };
+
 #ifdef _MSC_VER
 #pragma region CSVField::get Specializations
 #endif
@@ -0,0 +1,155 @@
+/** @file
+ *  @brief Passes rows from a parsing thread to a reading thread in batches
+ */
+
+#include "csv_row_queue.hpp"
+
+namespace csv {
+    namespace internals {
+        CSV_INLINE void RowBatchQueue::notify_all() {
+            std::lock_guard<std::mutex> lock(this->_lock);
+            this->_is_waitable.store(true, std::memory_order_release);
+            this->_cond.notify_all();
+        }
+
+        CSV_INLINE void RowBatchQueue::kill_all() {
+            this->flush();
+
+            std::function<void()> resume;
+            {
+                std::lock_guard<std::mutex> lock(this->_lock);
+                this->_is_waitable.store(false, std::memory_order_release);
+                this->_cond.notify_all();
+                resume = this->take_consumer_resume();
+            }
+
+            if (resume) resume();
+        }
+
+        CSV_INLINE void RowBatchQueue::publish() {
+            const size_t n_rows = this->_batch_in.size();
+
+            // Once a batch spilled over, later batches have to queue up behind it
+            if (this->_n_spilled.load(std::memory_order_acquire) > 0 || !this->_ring.try_push(this->_batch_in)) {
+                std::lock_guard<std::mutex> lock(this->_lock);
+                this->_spill.push_back(std::move(this->_batch_in));
+                this->_n_spilled.fetch_add(1, std::memory_order_release);
+            }
+
+            this->_batch_in = Batch();
+            this->_n_published.fetch_add(n_rows, std::memory_order_relaxed);
+
+            // Pairs with the fence in wait(): either the consumer sees the batch,
+            // or we see that it is waiting
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (this->_consumer_waiting.load(std::memory_order_relaxed)) {
+                std::function<void()> resume;
+                {
+                    std::lock_guard<std::mutex> lock(this->_lock);
+                    this->_cond.notify_all();
+                    resume = this->take_consumer_resume();
+                }
+
+                if (resume) resume();
+            }
+        }
+
+        CSV_INLINE bool RowBatchQueue::take_batch() {
+            if (!this->_ring.try_pop(this->_batch_out)) {
+                if (this->_n_spilled.load(std::memory_order_acquire) == 0)
+                    return false;
+
+                // The producer stops using the ring while batches are spilled, so
+                // anything still in it is older than the spilled batches
+                if (!this->_ring.try_pop(this->_batch_out)) {
+                    std::lock_guard<std::mutex> lock(this->_lock);
+                    this->_batch_out = std::move(this->_spill.front());
+                    this->_spill.pop_front();
+                    this->_n_spilled.fetch_sub(1, std::memory_order_release);
+                }
+            }
+
+            this->_pos = 0;
+            this->_n_taken.fetch_add(this->_batch_out.size(), std::memory_order_release);
+
+            // Pairs with the fence in resume_when_taken()
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (this->_producer_waiting.load(std::memory_order_relaxed)) {
+                std::function<void()> resume;
+                {
+                    std::lock_guard<std::mutex> lock(this->_lock);
+                    if (this->_resume && this->n_taken() >= this->_resume_at) {
+                        resume = std::move(this->_resume);
+                        this->_resume = nullptr;
+                        this->_producer_waiting.store(false, std::memory_order_relaxed);
+                    }
+                }
+
+                if (resume) resume();
+            }
+
+            return true;
+        }
+
+        CSV_INLINE void RowBatchQueue::wait() {
+            if (!this->is_waitable()) return;
+
+            std::unique_lock<std::mutex> lock(this->_lock);
+            this->_consumer_waiting.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            this->_cond.wait(lock, [this] { return this->has_batch() || !this->is_waitable(); });
+            this->_consumer_waiting.store(false, std::memory_order_relaxed);
+        }
+
+        CSV_INLINE bool RowBatchQueue::resume_when_available(std::function<void()> resume) {
+            std::lock_guard<std::mutex> lock(this->_lock);
+            this->_consumer_waiting.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            // Pairs with the fence in publish()
+            if (this->has_batch() || !this->is_waitable()) {
+                this->_consumer_waiting.store(false, std::memory_order_relaxed);
+                return false;
+            }
+
+            this->_resume_consumer = std::move(resume);
+            return true;
+        }
+
+        CSV_INLINE std::function<void()> RowBatchQueue::take_consumer_resume() {
+            std::function<void()> resume = std::move(this->_resume_consumer);
+            this->_resume_consumer = nullptr;
+            if (resume)
+                this->_consumer_waiting.store(false, std::memory_order_relaxed);
+
+            return resume;
+        }
+
+        CSV_INLINE bool RowBatchQueue::resume_when_taken(size_t n_rows, std::function<void()> resume) {
+            std::lock_guard<std::mutex> lock(this->_lock);
+            this->_producer_waiting.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            // Pairs with the fence in take_batch(): either we see the rows it took,
+            // or it sees that we are waiting
+            if (this->n_taken() >= n_rows || this->cancelled()) {
+                this->_producer_waiting.store(false, std::memory_order_relaxed);
+                return false;
+            }
+
+            this->_resume = std::move(resume);
+            this->_resume_at = n_rows;
+            return true;
+        }
+
+        CSV_INLINE void RowBatchQueue::cancel() {
+            std::lock_guard<std::mutex> lock(this->_lock);
+            this->_cancelled.store(true, std::memory_order_release);
+            this->_resume = nullptr;
+            this->_resume_consumer = nullptr;
+            this->_producer_waiting.store(false, std::memory_order_relaxed);
+            this->_cond.notify_all();
+        }
+    }
+}
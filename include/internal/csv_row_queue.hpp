@@ -0,0 +1,253 @@
+/** @file
+ *  @brief Passes rows from a parsing thread to a reading thread in batches
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "common.hpp"
+#include "csv_row.hpp"
+
+namespace csv {
+    namespace internals {
+        /** A bounded lock-free queue for exactly one producer thread and one consumer thread
+         *
+         *  @note The producer only writes `_tail` and the consumer only writes `_head`,
+         *        so each operation is one acquire load and one release store
+         */
+        template<typename T>
+        class SPSCRing {
+        public:
+            /** @param[in] capacity Rounded up to a power of two */
+            SPSCRing(size_t capacity) {
+                size_t size = 1;
+                while (size < capacity) size *= 2;
+
+                this->_slots = std::unique_ptr<T[]>(new T[size]); // For C++11
+                this->_mask = size - 1;
+            }
+
+            SPSCRing(const SPSCRing&) = delete;
+            SPSCRing& operator=(const SPSCRing&) = delete;
+
+            /** Called by the producer to add an item, which is left alone if the ring is full
+             *
+             *  @returns False if the ring was full
+             */
+            bool try_push(T& item) {
+                const size_t tail = this->_tail.load(std::memory_order_relaxed);
+                if (tail - this->_head.load(std::memory_order_acquire) > this->_mask)
+                    return false;
+
+                this->_slots[tail & this->_mask] = std::move(item);
+                this->_tail.store(tail + 1, std::memory_order_release);
+                return true;
+            }
+
+            /** Called by the consumer to remove the oldest item
+             *
+             *  @returns False if the ring was empty
+             */
+            bool try_pop(T& item) {
+                const size_t head = this->_head.load(std::memory_order_relaxed);
+                if (head == this->_tail.load(std::memory_order_acquire))
+                    return false;
+
+                item = std::move(this->_slots[head & this->_mask]);
+                this->_head.store(head + 1, std::memory_order_release);
+                return true;
+            }
+
+            bool empty() const noexcept {
+                return this->_head.load(std::memory_order_acquire) == this->_tail.load(std::memory_order_acquire);
+            }
+
+        private:
+            std::unique_ptr<T[]> _slots;
+            size_t _mask = 0;
+
+            /** Keep the indices on separate cache lines, so that the two threads do not
+             *  invalidate each other's caches every time one of them moves
+             */
+            char _pad0[64] = {};
+            std::atomic<size_t> _head{ 0 };
+            char _pad1[64] = {};
+            std::atomic<size_t> _tail{ 0 };
+            char _pad2[64] = {};
+        };
+
+        /** Passes rows from the thread which parses a CSV to the thread which reads it
+         *
+         *  @par Implementation
+         *  The producer collects rows into batches of `BATCH_SIZE` and publishes each
+         *  full batch to an SPSCRing, so synchronization costs one atomic store per
+         *  batch rather than a mutex per row. The consumer likewise takes a whole batch
+         *  at a time and hands out its rows without synchronizing.
+         *
+         *  If the consumer falls so far behind that the ring fills up (e.g. while a
+         *  CSVReader reads its first chunk before anyone consumes it), batches spill
+         *  over into a list guarded by a mutex. While the list is not empty, all batches
+         *  go through it, so rows are always consumed in the order they were pushed.
+         */
+        class RowBatchQueue {
+        public:
+            /** Number of rows in each batch */
+            static constexpr size_t BATCH_SIZE = 512;
+
+            /** @param[in] capacity Number of batches the lock-free ring can hold */
+            RowBatchQueue(size_t capacity = 256) : _ring(capacity) {}
+
+            RowBatchQueue(const RowBatchQueue&) = delete;
+            RowBatchQueue& operator=(const RowBatchQueue&) = delete;
+
+            /** @name Producer */
+            ///@{
+            void push_back(CSVRow&& row) {
+                if (this->_batch_in.empty())
+                    this->_batch_in.reserve(BATCH_SIZE);
+
+                this->_batch_in.push_back(std::move(row));
+                if (this->_batch_in.size() == BATCH_SIZE)
+                    this->publish();
+            }
+
+            /** Publish the rows of the unfinished batch */
+            void flush() {
+                if (!this->_batch_in.empty())
+                    this->publish();
+            }
+
+            /** Tell listeners that this queue is actively being pushed to */
+            void notify_all();
+
+            /** Publish any unfinished batch and tell all listeners to stop waiting */
+            void kill_all();
+
+            /** Have the consumer call `resume()` once it has taken at least `n_rows` rows in total,
+             *  so that the producer can stop without blocking its thread
+             *
+             *  @returns False if that many rows were already taken or the consumer called cancel(),
+             *           in which case `resume()` is never called
+             */
+            bool resume_when_taken(size_t n_rows, std::function<void()> resume);
+
+            /** Number of rows published so far */
+            size_t n_published() const noexcept { return this->_n_published.load(std::memory_order_relaxed); }
+
+            /** Number of rows taken by the consumer so far */
+            size_t n_taken() const noexcept { return this->_n_taken.load(std::memory_order_acquire); }
+
+            /** Whether the consumer called cancel() */
+            bool cancelled() const noexcept { return this->_cancelled.load(std::memory_order_acquire); }
+            ///@}
+
+            /** @name Consumer */
+            ///@{
+            /** Returns true if no rows are available right now */
+            bool empty() {
+                return this->_pos == this->_batch_out.size() && !this->take_batch();
+            }
+
+            /** @pre empty() returned false */
+            CSVRow& front() noexcept { return this->_batch_out[this->_pos]; }
+
+            /** @pre empty() returned false */
+            CSVRow pop_front() noexcept { return std::move(this->_batch_out[this->_pos++]); }
+
+            /** Returns true if a thread is actively pushing items to this queue */
+            bool is_waitable() const noexcept { return this->_is_waitable.load(std::memory_order_acquire); }
+
+            /** Wait for a batch to become available or the producer to stop */
+            void wait();
+
+            /** Have the producer call `resume()` once a batch is available or it stops,
+             *  so that the consumer does not have to block a thread in wait()
+             *
+             *  @returns False if a batch is already available or the producer already stopped,
+             *           in which case `resume()` is never called
+             */
+            bool resume_when_available(std::function<void()> resume);
+
+            /** Tell the producer that no more rows will be taken
+             *
+             *  @note Functions passed to resume_when_taken() or resume_when_available() which were
+             *        not called yet are discarded
+             */
+            void cancel();
+            ///@}
+
+            /** Approximately how many published rows the consumer has not taken yet */
+            size_t size() const noexcept {
+                return this->_n_published.load(std::memory_order_relaxed) - this->_n_taken.load(std::memory_order_relaxed);
+            }
+
+        private:
+            using Batch = std::vector<CSVRow>;
+
+            SPSCRing<Batch> _ring;
+
+            /** Batches which did not fit in the ring, guarded by _lock */
+            std::deque<Batch> _spill;
+            std::atomic<size_t> _n_spilled{ 0 };
+
+            /** Batch being filled by the producer */
+            Batch _batch_in;
+
+            /** Batch being read by the consumer */
+            Batch _batch_out;
+            size_t _pos = 0;
+
+            /** @see size() */
+            std::atomic<size_t> _n_published{ 0 };
+            std::atomic<size_t> _n_taken{ 0 };
+
+            std::atomic<bool> _is_waitable{ false };
+            std::atomic<bool> _cancelled{ false };
+
+            /** Whether either thread is blocked in wait() or called resume_when_available() or
+             *  resume_when_taken(),
+             *  so the other thread only takes the lock when somebody needs to be woken up
+             */
+            std::atomic<bool> _consumer_waiting{ false };
+            std::atomic<bool> _producer_waiting{ false };
+
+            /** @see resume_when_taken() */
+            std::function<void()> _resume;
+            size_t _resume_at = 0;
+
+            /** @see resume_when_available() */
+            std::function<void()> _resume_consumer;
+
+            /** Take the function passed to resume_when_available(), if any
+             *
+             *  @pre _lock is held
+             */
+            std::function<void()> take_consumer_resume();
+
+            std::mutex _lock;
+            std::condition_variable _cond;
+
+            /** Called by the producer to hand over _batch_in */
+            void publish();
+
+            /** Called by the consumer to replace _batch_out with the next batch
+             *
+             *  @returns False if no batch was available
+             */
+            bool take_batch();
+
+            /** Whether a batch is waiting to be taken */
+            bool has_batch() const noexcept {
+                return !this->_ring.empty() || this->_n_spilled.load(std::memory_order_acquire) > 0;
+            }
+        };
+    }
+}
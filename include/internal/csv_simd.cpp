@@ -0,0 +1,272 @@
+/** @file
+ *  @brief Vectorized routines for locating structural CSV characters
+ */
+
+#include <algorithm>
+
+#include "csv_simd.hpp"
+
+#ifdef CSV_HAS_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef CSV_HAS_AVX2
+#include <immintrin.h>
+
+#ifdef _MSC_VER
+#define CSV_TARGET_AVX2
+#else
+#define CSV_TARGET_AVX2 __attribute__((target("avx2,pclmul")))
+#endif
+#endif
+
+namespace csv {
+    namespace internals {
+        CSV_INLINE const char* find_special_scalar(const char* begin, const char* end, const SpecialChars& chars) noexcept {
+            for (; begin < end; begin++) {
+                const char ch = *begin;
+                if (ch == chars[0] || ch == chars[1] || ch == chars[2] || ch == chars[3])
+                    return begin;
+            }
+
+            return end;
+        }
+
+#ifdef CSV_HAS_SSE2
+        CSV_INLINE const char* find_special_sse2(const char* begin, const char* end, const SpecialChars& chars) noexcept {
+            const __m128i c0 = _mm_set1_epi8(chars[0]),
+                c1 = _mm_set1_epi8(chars[1]),
+                c2 = _mm_set1_epi8(chars[2]),
+                c3 = _mm_set1_epi8(chars[3]);
+
+            while (end - begin >= 16) {
+                const __m128i block = _mm_loadu_si128((const __m128i*)begin);
+                const __m128i matches = _mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi8(block, c0), _mm_cmpeq_epi8(block, c1)),
+                    _mm_or_si128(_mm_cmpeq_epi8(block, c2), _mm_cmpeq_epi8(block, c3))
+                );
+
+                const unsigned int mask = (unsigned int)_mm_movemask_epi8(matches);
+                if (mask)
+                    return begin + count_trailing_zeros(mask);
+
+                begin += 16;
+            }
+
+            return find_special_scalar(begin, end, chars);
+        }
+#endif
+
+#ifdef CSV_HAS_AVX2
+        CSV_TARGET_AVX2 static inline uint32_t avx2_match_mask(const char* in,
+            __m256i c0, __m256i c1, __m256i c2, __m256i c3) noexcept {
+            const __m256i block = _mm256_loadu_si256((const __m256i*)in);
+            const __m256i matches = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(block, c0), _mm256_cmpeq_epi8(block, c1)),
+                _mm256_or_si256(_mm256_cmpeq_epi8(block, c2), _mm256_cmpeq_epi8(block, c3))
+            );
+
+            return (uint32_t)_mm256_movemask_epi8(matches);
+        }
+
+        CSV_INLINE CSV_TARGET_AVX2 const char* find_special_avx2(const char* begin, const char* end, const SpecialChars& chars) noexcept {
+            const __m256i c0 = _mm256_set1_epi8(chars[0]),
+                c1 = _mm256_set1_epi8(chars[1]),
+                c2 = _mm256_set1_epi8(chars[2]),
+                c3 = _mm256_set1_epi8(chars[3]);
+
+            while (end - begin >= 64) {
+                const uint64_t mask = (uint64_t)avx2_match_mask(begin, c0, c1, c2, c3)
+                    | ((uint64_t)avx2_match_mask(begin + 32, c0, c1, c2, c3) << 32);
+                if (mask)
+                    return begin + count_trailing_zeros(mask);
+
+                begin += 64;
+            }
+
+            if (end - begin >= 32) {
+                const uint32_t mask = avx2_match_mask(begin, c0, c1, c2, c3);
+                if (mask)
+                    return begin + count_trailing_zeros(mask);
+
+                begin += 32;
+            }
+
+            return find_special_scalar(begin, end, chars);
+        }
+#endif
+
+        /** Compute the bitmaps for a block of at most 64 bytes one character at a time */
+        static inline void scalar_block_masks(const char* in, size_t length, const StructuralChars& chars,
+            uint64_t& separators, uint64_t& quotes) noexcept {
+            separators = 0;
+            quotes = 0;
+
+            for (size_t i = 0; i < length; i++) {
+                const char ch = in[i];
+                if (ch == chars.delim || ch == '\n' || ch == '\r')
+                    separators |= uint64_t(1) << i;
+                else if (chars.use_quote && ch == chars.quote)
+                    quotes |= uint64_t(1) << i;
+            }
+        }
+
+        /** Mask out separators which lie inside quoted regions and update the carried quote state
+         *
+         *  @param[in,out] in_quote All ones if the previous block ended inside quotes, zero otherwise
+         */
+        static inline uint64_t unquoted_separators(uint64_t separators, uint64_t quote_region, uint64_t& in_quote) noexcept {
+            quote_region ^= in_quote;
+            in_quote = (uint64_t)((int64_t)quote_region >> 63);
+            return separators & ~quote_region;
+        }
+
+        CSV_INLINE bool build_structural_index_scalar(const char* in, size_t length, const StructuralChars& chars,
+            uint64_t* separators, uint64_t* quotes, bool start_in_quote) noexcept {
+            uint64_t in_quote = start_in_quote ? ~uint64_t(0) : 0;
+
+            for (size_t offset = 0; offset < length; offset += 64) {
+                uint64_t seps, quote_bits;
+                scalar_block_masks(in + offset, std::min(length - offset, (size_t)64), chars, seps, quote_bits);
+                *(separators++) = unquoted_separators(seps, prefix_xor(quote_bits), in_quote);
+                *(quotes++) = quote_bits;
+            }
+
+            return in_quote != 0;
+        }
+
+#ifdef CSV_HAS_SSE2
+        /** Return a bitmask of the bytes in a 16 byte block equal to ch */
+        static inline uint64_t sse2_eq_mask(__m128i block, __m128i ch) noexcept {
+            return (uint64_t)(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(block, ch));
+        }
+
+        CSV_INLINE bool build_structural_index_sse2(const char* in, size_t length, const StructuralChars& chars,
+            uint64_t* separators, uint64_t* quotes, bool start_in_quote) noexcept {
+            const __m128i delim = _mm_set1_epi8(chars.delim),
+                quote = _mm_set1_epi8(chars.quote),
+                lf = _mm_set1_epi8('\n'),
+                cr = _mm_set1_epi8('\r');
+
+            uint64_t in_quote = start_in_quote ? ~uint64_t(0) : 0;
+            size_t offset = 0;
+
+            for (; offset + 64 <= length; offset += 64) {
+                uint64_t seps = 0, quote_bits = 0;
+
+                for (int i = 0; i < 4; i++) {
+                    const __m128i block = _mm_loadu_si128((const __m128i*)(in + offset + 16 * i));
+                    seps |= (sse2_eq_mask(block, delim) | sse2_eq_mask(block, lf) | sse2_eq_mask(block, cr)) << (16 * i);
+                    quote_bits |= sse2_eq_mask(block, quote) << (16 * i);
+                }
+
+                if (!chars.use_quote) quote_bits = 0;
+
+                *(separators++) = unquoted_separators(seps, prefix_xor(quote_bits), in_quote);
+                *(quotes++) = quote_bits;
+            }
+
+            if (offset < length) {
+                uint64_t seps, quote_bits;
+                scalar_block_masks(in + offset, length - offset, chars, seps, quote_bits);
+                *separators = unquoted_separators(seps, prefix_xor(quote_bits), in_quote);
+                *quotes = quote_bits;
+            }
+
+            return in_quote != 0;
+        }
+#endif
+
+#ifdef CSV_HAS_AVX2
+        /** Return a bitmask of the bytes in a 32 byte block equal to ch */
+        CSV_TARGET_AVX2 static inline uint64_t avx2_eq_mask(__m256i block, __m256i ch) noexcept {
+            return (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, ch));
+        }
+
+        /** Compute prefix_xor() with a carry-less multiplication by all ones */
+        CSV_TARGET_AVX2 static inline uint64_t clmul_prefix_xor(uint64_t bits) noexcept {
+            const __m128i product = _mm_clmulepi64_si128(
+                _mm_set_epi64x(0, (long long)bits), _mm_set1_epi8((char)0xFF), 0);
+            return (uint64_t)_mm_cvtsi128_si64(product);
+        }
+
+        CSV_INLINE CSV_TARGET_AVX2 bool build_structural_index_avx2(const char* in, size_t length, const StructuralChars& chars,
+            uint64_t* separators, uint64_t* quotes, bool start_in_quote) noexcept {
+            const __m256i delim = _mm256_set1_epi8(chars.delim),
+                quote = _mm256_set1_epi8(chars.quote),
+                lf = _mm256_set1_epi8('\n'),
+                cr = _mm256_set1_epi8('\r');
+
+            uint64_t in_quote = start_in_quote ? ~uint64_t(0) : 0;
+            size_t offset = 0;
+
+            for (; offset + 64 <= length; offset += 64) {
+                const __m256i lo = _mm256_loadu_si256((const __m256i*)(in + offset)),
+                    hi = _mm256_loadu_si256((const __m256i*)(in + offset + 32));
+
+                const uint64_t seps = avx2_eq_mask(lo, delim) | avx2_eq_mask(lo, lf) | avx2_eq_mask(lo, cr)
+                    | ((avx2_eq_mask(hi, delim) | avx2_eq_mask(hi, lf) | avx2_eq_mask(hi, cr)) << 32);
+                const uint64_t quote_bits = chars.use_quote ?
+                    (avx2_eq_mask(lo, quote) | (avx2_eq_mask(hi, quote) << 32)) : 0;
+
+                *(separators++) = unquoted_separators(seps, clmul_prefix_xor(quote_bits), in_quote);
+                *(quotes++) = quote_bits;
+            }
+
+            if (offset < length) {
+                uint64_t seps, quote_bits;
+                scalar_block_masks(in + offset, length - offset, chars, seps, quote_bits);
+                *separators = unquoted_separators(seps, prefix_xor(quote_bits), in_quote);
+                *quotes = quote_bits;
+            }
+
+            return in_quote != 0;
+        }
+#endif
+
+        CSV_INLINE bool cpu_has_avx2() noexcept {
+#if !defined(CSV_HAS_AVX2)
+            return false;
+#elif defined(_MSC_VER)
+            int info[4];
+            __cpuid(info, 0);
+            if (info[0] < 7) return false;
+
+            // AVX2 also requires the OS to save YMM registers on context switches
+            __cpuid(info, 1);
+            const bool osxsave = (info[2] & (1 << 27)) != 0,
+                avx = (info[2] & (1 << 28)) != 0;
+            const bool pclmul = (info[2] & (1 << 1)) != 0;
+            if (!pclmul || !osxsave || !avx || (_xgetbv(0) & 6) != 6) return false;
+
+            __cpuidex(info, 7, 0);
+            return (info[1] & (1 << 5)) != 0;
+#else
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("pclmul");
+#endif
+        }
+
+        CSV_INLINE FindSpecialFunc find_special_func() noexcept {
+#ifdef CSV_HAS_AVX2
+            if (cpu_has_avx2()) return &find_special_avx2;
+#endif
+#ifdef CSV_HAS_SSE2
+            return &find_special_sse2;
+#else
+            return &find_special_scalar;
+#endif
+        }
+
+        CSV_INLINE StructuralIndexFunc build_structural_index_func() noexcept {
+#ifdef CSV_HAS_AVX2
+            if (cpu_has_avx2()) return &build_structural_index_avx2;
+#endif
+#ifdef CSV_HAS_SSE2
+            return &build_structural_index_sse2;
+#else
+            return &build_structural_index_scalar;
+#endif
+        }
+    }
+}
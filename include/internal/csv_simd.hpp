@@ -0,0 +1,183 @@
+/** @file
+ *  @brief Vectorized routines for locating structural CSV characters
+ */
+
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "common.hpp"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// CSV_NO_SIMD may be defined to force the portable scalar code paths
+#if !defined(CSV_NO_SIMD) && (defined(__x86_64__) || defined(_M_X64) || \
+    (defined(__i386__) && defined(__SSE2__)) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define CSV_HAS_SSE2
+
+// AVX2 kernels are compiled regardless of the -m flags in use and are only
+// selected after a runtime CPU check
+#if defined(_MSC_VER) || (defined(__GNUC__) && (__GNUC__ >= 5)) || defined(__clang__)
+#define CSV_HAS_AVX2
+#endif
+#endif
+
+namespace csv {
+    namespace internals {
+        /** The characters a scan should stop at. Unused slots should
+         *  repeat one of the other characters.
+         */
+        using SpecialChars = std::array<char, 4>;
+
+        /** Signature shared by all implementations of find_special() */
+        using FindSpecialFunc = const char* (*)(const char*, const char*, const SpecialChars&);
+
+        /** Return the index of the lowest set bit of a non-zero integer */
+        inline int count_trailing_zeros(uint64_t mask) noexcept {
+#if defined(_MSC_VER) && defined(_M_X64)
+            unsigned long idx;
+            _BitScanForward64(&idx, mask);
+            return (int)idx;
+#elif defined(__GNUC__) || defined(__clang__)
+            return __builtin_ctzll(mask);
+#else
+            int idx = 0;
+            while (!(mask & 1)) {
+                mask >>= 1;
+                idx++;
+            }
+            return idx;
+#endif
+        }
+
+        /** Return a pointer to the first character in [begin, end) that is
+         *  one of `chars`, or `end` if there are none
+         */
+        const char* find_special_scalar(const char* begin, const char* end, const SpecialChars& chars) noexcept;
+
+#ifdef CSV_HAS_SSE2
+        /** SSE2 implementation of find_special_scalar() (16 bytes at a time) */
+        const char* find_special_sse2(const char* begin, const char* end, const SpecialChars& chars) noexcept;
+#endif
+
+#ifdef CSV_HAS_AVX2
+        /** AVX2 implementation of find_special_scalar() (64 bytes at a time)
+         *
+         *  @warning Only call this if cpu_has_avx2() returns true
+         */
+        const char* find_special_avx2(const char* begin, const char* end, const SpecialChars& chars) noexcept;
+#endif
+
+        /** Describes the characters which are structurally significant
+         *  when building a structural index
+         */
+        struct StructuralChars {
+            char delim;
+            char quote;
+
+            /** If false, quote is ignored */
+            bool use_quote;
+        };
+
+        /** Signature shared by all implementations of build_structural_index() */
+        using StructuralIndexFunc = bool (*)(const char*, size_t, const StructuralChars&, uint64_t*, uint64_t*, bool);
+
+        /** Bitwise XOR of all bits at or below each position, i.e.
+         *  bit i of the result is set if an odd number of bits in [0, i] are set
+         */
+        CONSTEXPR_14 uint64_t prefix_xor(uint64_t bits) noexcept {
+            bits ^= bits << 1;
+            bits ^= bits << 2;
+            bits ^= bits << 4;
+            bits ^= bits << 8;
+            bits ^= bits << 16;
+            bits ^= bits << 32;
+            return bits;
+        }
+
+        /** Return the number of set bits in an integer */
+        inline int popcount(uint64_t bits) noexcept {
+#if defined(_MSC_VER) && defined(_M_X64)
+            return (int)__popcnt64(bits);
+#elif defined(__GNUC__) || defined(__clang__)
+            return __builtin_popcountll(bits);
+#else
+            int count = 0;
+            for (; bits; bits &= bits - 1)
+                count++;
+            return count;
+#endif
+        }
+
+        /** Return the number of 64-bit words needed to index `length` bytes */
+        constexpr size_t index_words(size_t length) noexcept {
+            return (length + 63) / 64;
+        }
+
+        /** Return the position of the first set bit at or after `pos`, or
+         *  `n_words * 64` if there are none
+         */
+        inline size_t next_set_bit(const uint64_t* index, size_t n_words, size_t pos) noexcept {
+            size_t word = pos / 64;
+            if (word >= n_words) return n_words * 64;
+
+            uint64_t bits = index[word] & (~uint64_t(0) << (pos % 64));
+            while (!bits) {
+                if (++word == n_words) return n_words * 64;
+                bits = index[word];
+            }
+
+            return word * 64 + (size_t)count_trailing_zeros(bits);
+        }
+
+        /** Stage one of the bitmap parsing engine: Build a structural index of `length` bytes
+         *
+         *  For every 64 byte block starting at `in`, two bitmaps are written where bit i
+         *  corresponds to byte i of the block:
+         *   - `separators`: delimiters and newlines which are not inside a quoted region
+         *   - `quotes`: every quote character
+         *
+         *  Quoted regions are found by computing the prefix XOR of the quote bitmap,
+         *  so `""` escapes simply open and close a region.
+         *
+         *  @param[out] separators Array of at least index_words(length) words
+         *  @param[out] quotes     Array of at least index_words(length) words
+         *  @param[in]  in_quote   Whether or not `in` starts inside of a quoted region
+         *  @returns    Whether or not `in` ends inside of a quoted region
+         */
+        bool build_structural_index_scalar(const char* in, size_t length, const StructuralChars& chars,
+            uint64_t* separators, uint64_t* quotes, bool in_quote) noexcept;
+
+#ifdef CSV_HAS_SSE2
+        /** SSE2 implementation of build_structural_index_scalar() */
+        bool build_structural_index_sse2(const char* in, size_t length, const StructuralChars& chars,
+            uint64_t* separators, uint64_t* quotes, bool in_quote) noexcept;
+#endif
+
+#ifdef CSV_HAS_AVX2
+        /** AVX2 implementation of build_structural_index_scalar(), which uses
+         *  carry-less multiplication to compute quote regions
+         *
+         *  @warning Only call this if cpu_has_avx2() returns true
+         */
+        bool build_structural_index_avx2(const char* in, size_t length, const StructuralChars& chars,
+            uint64_t* separators, uint64_t* quotes, bool in_quote) noexcept;
+#endif
+
+        /** Whether or not the CPU we are running on supports AVX2 (and carry-less multiplication) */
+        bool cpu_has_avx2() noexcept;
+
+        /** Return the fastest implementation of build_structural_index_scalar()
+         *  supported by this CPU
+         */
+        StructuralIndexFunc build_structural_index_func() noexcept;
+
+        /** Return the fastest implementation of find_special_scalar()
+         *  supported by this CPU
+         */
+        FindSpecialFunc find_special_func() noexcept;
+    }
+}
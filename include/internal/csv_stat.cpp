@@ -21,6 +21,12 @@ namespace csv {
         this->calc();
     }
 
+    /** Calculate statistics for a CSV read sequentially from a stream such as `std::cin` */
+    CSV_INLINE CSVStat::CSVStat(std::istream& stream, CSVFormat format) :
+        reader(stream, format) {
+        this->calc();
+    }
+
     /** Return current means */
     CSV_INLINE std::vector<long double> CSVStat::get_mean() const {
         std::vector<long double> ret;        
@@ -90,14 +96,9 @@ namespace csv {
             }
         }
 
-        // Start threads
-        std::vector<std::thread> pool;
-        for (size_t i = 0; i < this->get_col_names().size(); i++)
-            pool.push_back(std::thread(&CSVStat::calc_worker, this, i));
-
-        // Block until done
-        for (auto& th : pool)
-            th.join();
+        // Calculate each column's statistics as a task on the reader's executor
+        internals::run_parallel(this->reader.get_format().get_executor(), this->get_col_names().size(),
+            [this](size_t i) { this->calc_worker(i); });
 
         this->records.clear();
     }
@@ -33,6 +33,7 @@ namespace csv {
 
         CSVStat(csv::string_view filename, CSVFormat format = CSVFormat::guess_csv());
         CSVStat(std::stringstream& source, CSVFormat format = CSVFormat());
+        CSVStat(std::istream& source, CSVFormat format = CSVFormat());
     private:
         // An array of rolling averages
         // Each index corresponds to the rolling mean for the column at said index
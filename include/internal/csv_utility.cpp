@@ -1,19 +1,128 @@
+#include <numeric>
 #include <sstream>
 #include <vector>
 
 #include "csv_utility.hpp"
 
 namespace csv {
+    namespace internals {
+        /** @par Implementation
+         *  The input is indexed 64KB at a time with the bitmap engine's stage one. Every
+         *  unquoted separator is then either a newline ending a row, or one of its delimiters.
+         */
+        template<typename OnRow>
+        size_t for_each_row(csv::string_view in, const StructuralChars& chars, OnRow on_row) {
+            const size_t block_size = 64 * 1024;
+            const auto build_index = build_structural_index_func();
+
+            std::vector<uint64_t> separators(index_words(block_size)),
+                quotes(index_words(block_size));
+
+            bool in_quote = false;
+            size_t row_start = 0, row_delims = 0;
+
+            for (size_t offset = 0; offset < in.size(); offset += block_size) {
+                const size_t length = std::min(block_size, in.size() - offset);
+                in_quote = build_index(in.data() + offset, length, chars, separators.data(), quotes.data(), in_quote);
+
+                for (size_t word = 0; word < index_words(length); word++) {
+                    for (uint64_t bits = separators[word]; bits; bits &= bits - 1) {
+                        const size_t pos = offset + word * 64 + (size_t)count_trailing_zeros(bits);
+                        if (in[pos] != '\r' && in[pos] != '\n') {
+                            row_delims++;
+                            continue;
+                        }
+
+                        // Consecutive newlines do not create empty rows
+                        if (pos > row_start && !on_row(row_delims + 1))
+                            return find_row_start(in, pos, false, chars);
+
+                        row_delims = 0;
+                        row_start = pos + 1;
+                    }
+                }
+            }
+
+            // Last row without a trailing newline
+            if (row_start < in.size())
+                on_row(row_delims + 1);
+
+            return in.size();
+        }
+
+        CSV_INLINE size_t count_rows(csv::string_view in, const CSVFormat& format, size_t n_threads) {
+            const StructuralChars chars = { format.get_delim(), format.get_quote_char(), format.is_quoting_enabled() };
+
+            // Skip the UTF-8 BOM
+            if (in.size() >= 3 && in[0] == '\xEF' && in[1] == '\xBB' && in[2] == '\xBF')
+                in = in.substr(3);
+
+            // Skip the header and any rows before it
+            size_t n_cols = format.get_col_names().size();
+            const int header = format.get_header();
+            if (header >= 0) {
+                int row = 0;
+                in = in.substr(for_each_row(in, chars, [&](size_t n_fields) {
+                    if (row++ < header)
+                        return true;
+
+                    n_cols = n_fields;
+                    return false;
+                }));
+            }
+
+            if (in.empty())
+                return 0;
+
+            // Split the data into ranges which each begin at the start of a row
+            const size_t n_ranges = std::max((size_t)1, std::min(n_threads, in.size()));
+            std::vector<size_t> row_starts(n_ranges + 1, 0), n_rows(n_ranges, 0);
+            std::vector<char> odd_quotes(n_ranges, false);
+
+            if (chars.use_quote) {
+                run_parallel(format.get_executor(), n_ranges, [&](size_t i) {
+                    odd_quotes[i] = std::count(in.data() + in.size() * i / n_ranges,
+                        in.data() + in.size() * (i + 1) / n_ranges, chars.quote) % 2 == 1;
+                });
+            }
+
+            bool quoted = false;
+            for (size_t i = 1; i < n_ranges; i++) {
+                quoted ^= (odd_quotes[i - 1] != 0);
+                row_starts[i] = std::max(find_row_start(in, in.size() * i / n_ranges, quoted, chars), row_starts[i - 1]);
+            }
+
+            row_starts[n_ranges] = in.size();
+
+            // Count rows which CSVReader would not discard
+            const bool keep_all = format.get_variable_column_policy() == VariableColumnPolicy::KEEP;
+            run_parallel(format.get_executor(), n_ranges, [&](size_t i) {
+                auto range = in.substr(row_starts[i], row_starts[i + 1] - row_starts[i]);
+                for_each_row(range, chars, [&](size_t n_fields) {
+                    if (keep_all || n_fields == n_cols)
+                        n_rows[i]++;
+
+                    return true;
+                });
+            });
+
+            return std::accumulate(n_rows.begin(), n_rows.end(), (size_t)0);
+        }
+    }
+
     /** Shorthand function for parsing an in-memory CSV string
      *
      *  @return A collection of CSVRow objects
      *
+     *  @note `in` is copied once, so it does not need to outlive the result.
+     *        To parse memory in place, use `CSVReader(csv::in_memory, ...)`.
+     *
      *  @par Example
      *  @snippet tests/test_read_csv.cpp Parse Example
      */
     CSV_INLINE CSVReader parse(csv::string_view in, CSVFormat format) {
-        std::stringstream stream(in.data());
-        return CSVReader(stream, format);
+        auto data = std::make_shared<std::string>(in.data(), in.size());
+        return CSVReader(in_memory, *data, format, data);
     }
 
     /** Parses a CSV string with no headers
@@ -21,10 +130,7 @@ namespace csv {
      *  @return A collection of CSVRow objects
      */
     CSV_INLINE CSVReader parse_no_header(csv::string_view in) {
-        CSVFormat format;
-        format.header_row(-1);
-
-        return parse(in, format);
+        return parse(in, CSVFormat().header_row(-1));
     }
 
     /** Parse a RFC 4180 CSV string, returning a collection
@@ -35,12 +141,39 @@ namespace csv {
      *
      */
     CSV_INLINE CSVReader operator ""_csv(const char* in, size_t n) {
-        return parse(csv::string_view(in, n));
+        // String literals outlive any rows, so they can be parsed in place
+        return CSVReader(in_memory, csv::string_view(in, n));
     }
 
     /** A shorthand for csv::parse_no_header() */
     CSV_INLINE CSVReader operator ""_csv_no_header(const char* in, size_t n) {
-        return parse_no_header(csv::string_view(in, n));
+        return CSVReader(in_memory, csv::string_view(in, n), CSVFormat().header_row(-1));
+    }
+
+    /** Keep rows where `column` is exactly equal to `value` */
+    CSV_INLINE RowFilter column_equals(const std::string& column, const std::string& value) {
+        return [column, value](const CSVRow& row) {
+            return row[column].get<csv::string_view>() == csv::string_view(value);
+        };
+    }
+
+    /** Keep rows where `column` is a number in the closed interval [min, max] */
+    CSV_INLINE RowFilter column_between(const std::string& column, long double min, long double max) {
+        return [column, min, max](const CSVRow& row) {
+            auto field = row[column];
+            if (!field.is_num())
+                return false;
+
+            const long double value = field.get<long double>();
+            return value >= min && value <= max;
+        };
+    }
+
+    /** Keep rows where `column` starts with `prefix` */
+    CSV_INLINE RowFilter column_starts_with(const std::string& column, const std::string& prefix) {
+        return [column, prefix](const CSVRow& row) {
+            return row[column].get<csv::string_view>().substr(0, prefix.size()) == csv::string_view(prefix);
+        };
     }
 
     /**
@@ -62,18 +195,59 @@ namespace csv {
      *  @include programs/csv_info.cpp
      */
     CSV_INLINE CSVFileInfo get_file_info(const std::string& filename) {
-        CSVReader reader(filename);
-        CSVFormat format = reader.get_format();
-        for (auto it = reader.begin(); it != reader.end(); ++it);
+        CSVFormat format = CSVFormat::guess_csv();
+        auto guess_result = guess_format(filename, format.get_possible_delims());
+        format.delimiter(guess_result.delim).header_row(guess_result.header_row);
+
+        auto col_names = get_col_names(filename, format);
 
         CSVFileInfo info = {
             filename,
-            reader.get_col_names(),
+            col_names,
             format.get_delim(),
-            reader.n_rows(),
-            reader.get_col_names().size()
+            count_rows(filename, format),
+            col_names.size()
         };
 
         return info;
     }
-}
\ No newline at end of file
+
+    /** Count the rows in a CSV file without creating any CSVRow objects
+     *
+     *  Like CSVReader::n_rows(), this does not count the header or the rows before it, and
+     *  rows with the wrong number of columns are not counted unless the variable column policy
+     *  is KEEP. Only quote state and newlines are tracked, using the same vectorized structural
+     *  index as the parser, and large files are split across all available threads.
+     *
+     *  @note Results may differ from CSVReader for files with malformed quoting
+     *  @note Compressed files are parsed with CSVReader instead
+     *
+     *  @param[in] filename  Path to CSV file
+     *  @param[in] format    Format of the CSV file
+     */
+    CSV_INLINE size_t count_rows(csv::string_view filename, CSVFormat format) {
+        if (format.guess_delim()) {
+            auto guess_result = guess_format(filename, format.get_possible_delims());
+            format.delimiter(guess_result.delim).header_row(guess_result.header_row);
+        }
+
+        if (internals::get_file_size(filename) == 0)
+            return 0;
+
+        // Compressed files have to be parsed
+        if (internals::detect_compression(filename) != internals::Compression::NONE) {
+            CSVReader reader(filename, format);
+            for (auto& row : reader) { (void)row; }
+            return reader.n_rows();
+        }
+
+        std::error_code error;
+        auto mmap = mio::make_mmap_source(std::string(filename), 0, mio::map_entire_file, error);
+        if (error) throw error;
+
+        // Give each thread at least ITERATION_CHUNK_SIZE bytes
+        const size_t n_threads = std::min(format.get_executor().size(),
+            mmap.length() / internals::ITERATION_CHUNK_SIZE + 1);
+        return internals::count_rows(csv::string_view(mmap.data(), mmap.length()), format, n_threads);
+    }
+}
@@ -28,10 +28,40 @@ namespace csv {
     CSVReader parse_no_header(csv::string_view in);
     ///@}
 
+    /** @name Row Filters
+     *  @brief Common predicates for CSVFormat::filter()
+     */
+     ///@{
+    RowFilter column_equals(const std::string& column, const std::string& value);
+    RowFilter column_between(const std::string& column, long double min, long double max);
+    RowFilter column_starts_with(const std::string& column, const std::string& prefix);
+    ///@}
+
+    namespace internals {
+        /** Call `on_row(n_fields)` for every row of `in` until it returns false
+         *
+         *  @param[in] in     CSV data which begins at the start of a row
+         *  @param[in] on_row Callable taking the number of fields in a row and
+         *                    returning whether or not to continue
+         *  @returns   Where the row after the last row visited begins
+         */
+        template<typename OnRow>
+        size_t for_each_row(csv::string_view in, const StructuralChars& chars, OnRow on_row);
+
+        /** Count the rows of an in-memory CSV like count_rows() does for files
+         *
+         *  @param[in] format    A format whose delimiter is known
+         *  @param[in] n_threads The number of ranges to split `in` into, which are
+         *                       counted concurrently on the format's Executor
+         */
+        size_t count_rows(csv::string_view in, const CSVFormat& format, size_t n_threads = 1);
+    }
+
     /** @name Utility Functions */
     ///@{
     std::unordered_map<std::string, DataType> csv_data_types(const std::string&);
     CSVFileInfo get_file_info(const std::string& filename);
+    size_t count_rows(csv::string_view filename, CSVFormat format = CSVFormat::guess_csv());
     int get_col_pos(csv::string_view filename, csv::string_view col_name,
         const CSVFormat& format = CSVFormat::guess_csv());
     ///@}
@@ -16,33 +16,31 @@ int main(int argc, char** argv) {
     // Benchmark 1: File IO + Parsing
     std::string filename = argv[1];
     auto start = std::chrono::system_clock::now();
-    auto info = get_file_info(filename);
+    CSVReader reader(filename);
+    size_t n_rows = 0;
+    for (auto& row : reader) {
+        (void)row;
+        n_rows++;
+    }
     auto end = std::chrono::system_clock::now();
     std::chrono::duration<double> diff = end - start;
 
     std::cout << "Parsing took (including disk IO): " << diff.count() << std::endl;
-    std::cout << "Dimensions: " << info.n_rows << " rows x " << info.n_cols << " columns " << std::endl;
+    std::cout << "Dimensions: " << n_rows << " rows x " << reader.get_col_names().size() << " columns " << std::endl;
     std::cout << "Columns: ";
-    for (auto& col : info.col_names) {
+    for (auto& col : reader.get_col_names()) {
         std::cout << " " << col;
     }
     std::cout << std::endl;
 
-    // Benchmark 2: Parsing Only
-    /*
-    std::ifstream csv(filename);
-    std::stringstream buffer;
-    buffer << csv.rdbuf();
-
-    auto csv_str = buffer.str();
-
+    // Benchmark 2: Counting rows without creating CSVRows
     start = std::chrono::system_clock::now();
-    parse(csv_str);
+    n_rows = count_rows(filename, reader.get_format());
     end = std::chrono::system_clock::now();
     diff = end - start;
 
-    std::cout << "Parsing took: " << diff.count() << std::endl;
-    */
+    std::cout << "Counting rows took (including disk IO): " << diff.count() << std::endl;
+    std::cout << "Rows: " << n_rows << std::endl;
 
     return 0;
 }
\ No newline at end of file
@@ -5,14 +5,25 @@ int main(int argc, char** argv) {
     using namespace csv;
 
     if (argc < 2) {
-        std::cout << "Usage: " << argv[0] << " [file]" << std::endl;
+        std::cout << "Usage: " << argv[0] << " [file]" << std::endl
+            << "Use - as the file to read from standard input" << std::endl;
         exit(1);
     }
 
     std::string file = argv[1];
-    auto info = get_file_info(file);
+    CSVFileInfo info;
+    if (file == "-") {
+        CSVReader reader(std::cin);
+        for (auto& row : reader) { (void)row; }
 
-    std::cout << file << std::endl
+        info = { "<stdin>", reader.get_col_names(), reader.get_format().get_delim(),
+            reader.n_rows(), reader.get_col_names().size() };
+    }
+    else {
+        info = get_file_info(file);
+    }
+
+    std::cout << info.filename << std::endl
         << "Columns: " << internals::format_row(info.col_names, ", ")
         << "Dimensions: " << info.n_rows << " rows x " << info.n_cols << " columns" << std::endl
         << "Delimiter: " << info.delim << std::endl;
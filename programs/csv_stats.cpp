@@ -4,12 +4,21 @@ int main(int argc, char** argv) {
     using namespace csv;
 
     if (argc < 2) {
-        std::cout << "Usage: " << argv[0] << " [file]" << std::endl;
+        std::cout << "Usage: " << argv[0] << " [file]" << std::endl
+            << "Use - as the file to read from standard input" << std::endl;
         exit(1);
     }
 
     std::string filename = argv[1];
-    CSVStat stats(filename);
+    std::unique_ptr<CSVStat> stats_ptr;
+    if (filename == "-") {
+        stats_ptr = std::unique_ptr<CSVStat>(new CSVStat(std::cin));
+    }
+    else {
+        stats_ptr = std::unique_ptr<CSVStat>(new CSVStat(filename));
+    }
+
+    auto& stats = *stats_ptr;
 
     auto col_names = stats.get_col_names();
     auto min = stats.get_mins(), max = stats.get_maxes(),
@@ -83,3 +83,20 @@ TEST_CASE("Test CSVFieldArray Thread Safety", "[test_array_thread]") {
         REQUIRE(result.get() == true);
     }
 }
+
+TEST_CASE("Test Compact RawCSVField Limits", "[test_raw_field_limits]") {
+    STATIC_ASSERT(sizeof(RawCSVField) == 8);
+    const size_t max_start = RawCSVField::MAX_START, max_length = RawCSVField::MAX_LENGTH;
+
+    RawCSVField largest(max_start, max_length, true);
+    REQUIRE(largest.start == max_start);
+    REQUIRE(largest.length == max_length);
+    REQUIRE(largest.has_double_quote);
+
+    RawCSVField unquoted(1, max_length);
+    REQUIRE(unquoted.length == max_length);
+    REQUIRE_FALSE(unquoted.has_double_quote);
+
+    REQUIRE_THROWS_AS(RawCSVField(max_start + 1, 0), std::runtime_error);
+    REQUIRE_THROWS_AS(RawCSVField(0, max_length + 1), std::runtime_error);
+}
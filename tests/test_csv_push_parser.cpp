@@ -0,0 +1,94 @@
+/** @file
+ *  Tests for CSVPushParser
+ */
+
+#include <random>
+#include <catch2/catch_all.hpp>
+#include "csv.hpp"
+
+using namespace csv;
+using std::vector;
+using std::string;
+
+namespace {
+    vector<vector<string>> read_all(CSVReader& reader) {
+        vector<vector<string>> ret;
+        for (auto& row : reader) {
+            ret.push_back(vector<string>(row));
+        }
+
+        return ret;
+    }
+}
+
+TEST_CASE("Push Parser Matches CSVReader", "[push_parser]") {
+    string csv_string = "A,B,C\r\n";
+    for (int i = 0; i < 300; i++) {
+        csv_string += "\"quoted\r\n, \"\"field\"\"\"," + std::to_string(i) + ",x\r\n";
+        if (i % 7 == 0) csv_string += "too,short\n";
+    }
+    csv_string += "1,2,3";
+
+    auto expected_reader = parse(csv_string);
+    auto expected = read_all(expected_reader);
+    REQUIRE(expected.size() == 301);
+
+    // Feed the data in pieces of random sizes, including empty ones
+    std::mt19937 rng(42);
+    for (size_t max_piece : { 1, 3, 64, 65536 }) {
+        CSVPushParser parser;
+        vector<vector<string>> actual;
+        CSVRow row;
+
+        for (size_t pos = 0; pos < csv_string.size();) {
+            const size_t length = std::min(rng() % (max_piece + 1), csv_string.size() - pos);
+            parser.feed(csv_string.data() + pos, length);
+            pos += length;
+
+            while (parser.read_row(row))
+                actual.push_back(vector<string>(row));
+        }
+
+        REQUIRE(!parser.eof());
+        parser.finish();
+        while (parser.read_row(row))
+            actual.push_back(vector<string>(row));
+
+        REQUIRE(parser.eof());
+        REQUIRE(parser.get_col_names() == vector<string>({ "A", "B", "C" }));
+        REQUIRE(parser.n_rows() == expected.size());
+        REQUIRE(actual == expected);
+    }
+}
+
+TEST_CASE("Push Parser Callback", "[push_parser_callback]") {
+    vector<string> first_col;
+    CSVPushParser parser(CSVFormat().header_row(-1), [&first_col](CSVRow& row) {
+        first_col.push_back(row[0].get<string>());
+    });
+
+    // Rows are delivered as soon as they are complete
+    parser.feed("1,\"a");
+    REQUIRE(first_col.empty());
+    parser.feed("\n\",x\r");
+    REQUIRE(first_col == vector<string>({ "1" }));
+    parser.feed("\n2,");
+    parser.feed(csv::string_view("b,y"));
+    REQUIRE(first_col == vector<string>({ "1" }));
+    parser.finish();
+    REQUIRE(first_col == vector<string>({ "1", "2" }));
+
+    CSVRow row;
+    REQUIRE(!parser.read_row(row));
+    REQUIRE_THROWS_AS(parser.feed("3,c,z"), std::runtime_error);
+}
+
+TEST_CASE("Push Parser Variable Column Policy", "[push_parser_var_len]") {
+    CSVPushParser parser(CSVFormat().variable_columns(VariableColumnPolicy::THROW));
+    parser.feed("A,B\n1,2\n3\n");
+
+    CSVRow row;
+    REQUIRE(parser.read_row(row));
+    REQUIRE(row["B"] == "2");
+    REQUIRE_THROWS_WITH(parser.read_row(row), Catch::Matchers::StartsWith("Line too short"));
+}
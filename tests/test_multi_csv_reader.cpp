@@ -0,0 +1,185 @@
+/** @file
+ *  Tests for MultiCSVReader
+ */
+
+#include <stdio.h> // remove()
+#include <algorithm>
+#include <fstream>
+#include <catch2/catch_all.hpp>
+#include "csv.hpp"
+
+using namespace csv;
+using std::vector;
+using std::string;
+
+namespace {
+    /** Write `n_shards` semicolon-separated files with different numbers of rows,
+     *  returning the rows of every file in order
+     */
+    vector<vector<string>> write_shards(const string& prefix, size_t n_shards, vector<string>& filenames) {
+        vector<vector<string>> rows;
+        for (size_t shard = 0; shard < n_shards; shard++) {
+            const string filename = prefix + std::to_string(shard) + ".csv";
+            std::ofstream outfile(filename, std::ios::binary);
+            outfile << "Shard;Row;Text\r\n";
+
+            // Shard 3 only has a header
+            const size_t n_rows = shard == 3 ? 0 : 2000 * (shard % 4 + 1);
+            for (size_t i = 0; i < n_rows; i++) {
+                vector<string> row = { std::to_string(shard), std::to_string(i), "a \"\"quoted\"\"\n; text" };
+                outfile << row[0] << ";" << row[1] << ";\"" << row[2] << "\"\r\n";
+                row[2] = "a \"quoted\"\n; text";
+                rows.push_back(row);
+            }
+
+            filenames.push_back(filename);
+        }
+
+        return rows;
+    }
+
+    vector<vector<string>> read_all(MultiCSVReader& reader) {
+        vector<vector<string>> rows;
+        RowBatch batch;
+        while (reader.read_rows(batch, 700)) {
+            for (auto& row : batch) {
+                REQUIRE(reader.current_file().find("shard_" + row["Shard"].get<string>() + ".csv") != string::npos);
+                rows.push_back(vector<string>(row));
+            }
+        }
+
+        return rows;
+    }
+}
+
+TEST_CASE("MultiCSVReader Reads Every Shard", "[multi_csv_reader]") {
+    vector<string> filenames;
+    auto expected = write_shards("shard_", 8, filenames);
+
+    Executor executor(3);
+    CSVFormat format = CSVFormat::guess_csv();
+    format.chunk_size(1 << 14).executor(executor);
+
+    SECTION("File Order") {
+        MultiCSVReader reader(filenames, format, ShardOrder::FILE_ORDER);
+        REQUIRE(reader.get_col_names() == vector<string>({ "Shard", "Row", "Text" }));
+        REQUIRE(reader.get_format().get_delim() == ';');
+
+        REQUIRE(read_all(reader) == expected);
+        REQUIRE(reader.n_rows() == expected.size());
+    }
+
+    SECTION("Arrival Order") {
+        MultiCSVReader reader(filenames, format, ShardOrder::ARRIVAL_ORDER);
+        auto rows = read_all(reader);
+        REQUIRE(reader.n_rows() == expected.size());
+
+        // Rows of each file stay in order
+        std::stable_sort(rows.begin(), rows.end(), [](const vector<string>& a, const vector<string>& b) {
+            return std::stoi(a[0]) < std::stoi(b[0]);
+        });
+
+        REQUIRE(rows == expected);
+    }
+
+    SECTION("read_row()") {
+        MultiCSVReader reader(filenames, format, ShardOrder::ARRIVAL_ORDER, 2);
+        vector<vector<string>> rows;
+        CSVRow row;
+        while (reader.read_row(row))
+            rows.push_back(vector<string>(row));
+
+        REQUIRE(rows.size() == expected.size());
+    }
+
+#ifdef CSV_HAS_GLOB
+    SECTION("glob_files()") {
+        auto matches = glob_files("shard_*.csv");
+        REQUIRE(matches == filenames);
+
+        MultiCSVReader reader(matches, format);
+        REQUIRE(read_all(reader) == expected);
+    }
+#endif
+
+    SECTION("Readers Destroyed Early") {
+        MultiCSVReader reader(filenames, format, ShardOrder::ARRIVAL_ORDER);
+        CSVRow row;
+        REQUIRE(reader.read_row(row));
+    }
+
+    for (auto& filename : filenames)
+        remove(filename.c_str());
+}
+
+TEST_CASE("MultiCSVReader Rejects Shards with Other Columns", "[multi_csv_reader_columns]") {
+    vector<string> filenames;
+    auto expected = write_shards("columns_", 3, filenames);
+    {
+        std::ofstream outfile(filenames[1], std::ios::binary);
+        outfile << "Shard;Row;Other\r\n1;1;x\r\n";
+    }
+
+    // Only the rows of the first and last shard are read
+    const size_t n_rows = 2000 + 6000;
+    expected.erase(expected.begin() + 2000, expected.end() - 6000);
+
+    MultiCSVReader reader(filenames);
+    vector<vector<string>> rows;
+    bool error_caught = false;
+
+    while (true) {
+        try {
+            CSVRow row;
+            if (!reader.read_row(row)) break;
+            rows.push_back(vector<string>(row));
+        }
+        catch (std::runtime_error& err) {
+            error_caught = true;
+            REQUIRE(string(err.what()).find(filenames[1]) != string::npos);
+        }
+    }
+
+    REQUIRE(error_caught);
+    REQUIRE(rows.size() == n_rows);
+    REQUIRE(rows == expected);
+
+    for (auto& filename : filenames)
+        remove(filename.c_str());
+}
+
+TEST_CASE("MultiCSVReader Reports Missing Shards", "[multi_csv_reader_missing]") {
+    for (bool empty : { false, true }) {
+        vector<string> filenames;
+        auto expected = write_shards("missing_", 3, filenames);
+        remove(filenames[1].c_str());
+        if (empty) {
+            std::ofstream outfile(filenames[1], std::ios::binary);
+        }
+
+        // Only the rows of the first and last shard are read
+        expected.erase(expected.begin() + 2000, expected.end() - 6000);
+
+        MultiCSVReader reader(filenames);
+        vector<vector<string>> rows;
+        bool error_caught = false;
+
+        while (true) {
+            try {
+                CSVRow row;
+                if (!reader.read_row(row)) break;
+                rows.push_back(vector<string>(row));
+            }
+            catch (std::runtime_error& err) {
+                error_caught = true;
+                REQUIRE(string(err.what()).find(filenames[1]) != string::npos);
+            }
+        }
+
+        REQUIRE(error_caught);
+        REQUIRE(rows == expected);
+
+        for (auto& filename : filenames)
+            remove(filename.c_str());
+    }
+}
@@ -2,7 +2,11 @@
 #include "internal/basic_csv_parser.hpp"
 #include "internal/csv_row.hpp"
 
+#include <cstdio>
+#include <fstream>
+#include <random>
 #include <sstream>
+#include <thread>
 
 using namespace csv;
 using namespace csv::internals;
@@ -252,3 +256,522 @@ TEST_CASE("Test Parser Whitespace Trimming w/ Empty Fields", "[test_raw_ws_trim]
         }
     }
 }
+
+namespace {
+    std::vector<std::vector<std::string>> parse_rows(const std::string& csv_string, const WhitespaceMap& ws_flags,
+        const ParseFlagMap& parse_flags = internals::make_parse_flags(',', '"')) {
+        RowCollectionTest rows;
+
+        auto csv = std::stringstream(csv_string);
+        StreamParser<std::stringstream> parser(
+            csv,
+            parse_flags,
+            ws_flags
+        );
+
+        parser.set_output(rows);
+        parser.next();
+
+        std::vector<std::vector<std::string>> ret;
+        for (auto& row : rows) {
+            ret.push_back(std::vector<std::string>(row));
+        }
+
+        return ret;
+    }
+}
+
+TEST_CASE("Bitmap Engine Matches State Machine", "[test_bitmap_engine]") {
+    // Trimming a character which never appears in the input disables
+    // the bitmap engine without changing the parse results
+    const WhitespaceMap no_trim = WhitespaceMap(),
+        state_machine_only = internals::make_ws_flags({ '\x01' });
+
+    SECTION("Quote Heavy Input") {
+        std::string csv_string = "A,B,C\r\n";
+        for (int i = 0; i < 100; i++) {
+            csv_string += "\"free text, with \"\"quotes\"\"\nand newlines\",";
+            csv_string += std::to_string(i) + ",\"\"\r\n";
+        }
+
+        auto rows = parse_rows(csv_string, no_trim);
+        REQUIRE(rows.size() == 101);
+        REQUIRE(rows[1] == std::vector<std::string>({
+            "free text, with \"quotes\"\nand newlines", "0", "" }));
+        REQUIRE(rows == parse_rows(csv_string, state_machine_only));
+    }
+
+    SECTION("Malformed Input") {
+        const std::string alphabet = "ab,,\"\"\"\n\r";
+        std::mt19937 rng(4180);
+
+        for (int i = 0; i < 2000; i++) {
+            std::string csv_string(rng() % 300, 'a');
+            for (auto& ch : csv_string)
+                ch = alphabet[rng() % alphabet.size()];
+
+            REQUIRE(parse_rows(csv_string, no_trim) == parse_rows(csv_string, state_machine_only));
+        }
+    }
+
+    SECTION("Quote Free Input") {
+        const std::string alphabet = "ab,,\n\r";
+        std::mt19937 rng(1);
+
+        for (int i = 0; i < 2000; i++) {
+            std::string csv_string(rng() % 300, 'a');
+            for (auto& ch : csv_string)
+                ch = alphabet[rng() % alphabet.size()];
+
+            REQUIRE(parse_rows(csv_string, no_trim) == parse_rows(csv_string, state_machine_only));
+        }
+    }
+
+    SECTION("Quoting Disabled") {
+        const auto no_quote = internals::make_parse_flags(',');
+        std::string csv_string = "A,B,C\r\n"
+            "\"1,2\",3\r\n"
+            "\"\",,\"x\n"
+            "4,5,6";
+
+        auto rows = parse_rows(csv_string, no_trim, no_quote);
+        REQUIRE(rows.size() == 4);
+        REQUIRE(rows[1] == std::vector<std::string>({ "\"1", "2\"", "3" }));
+        REQUIRE(rows[2] == std::vector<std::string>({ "\"\"", "", "\"x" }));
+        REQUIRE(rows == parse_rows(csv_string, state_machine_only, no_quote));
+    }
+}
+
+TEST_CASE("Static Dialect Drives Every Parsing Engine", "[test_static_dialect_engines]") {
+    // The parser's runtime tables say ',' and '"', while its static dialect says
+    // ';' and '\''. Rows are only split on ';' if every engine which parses
+    // complete rows, not just the state machine, is specialized on the dialect.
+    auto parse_static = [](const std::string& csv_string) {
+        RowCollectionTest rows;
+        auto csv = std::stringstream(csv_string);
+        StreamParser<std::stringstream> parser(csv, internals::make_parse_flags(',', '"'), WhitespaceMap());
+        parser.use_static_dialect<';', '\'', true>();
+        parser.set_output(rows);
+        parser.next();
+
+        std::vector<std::vector<std::string>> ret;
+        for (auto& row : rows)
+            ret.push_back(std::vector<std::string>(row));
+
+        return ret;
+    };
+
+    SECTION("Quote Free Input") {
+        std::string csv_string = "A;B,C\r\n";
+        for (int i = 0; i < 100; i++)
+            csv_string += std::to_string(i) + ",x;\"y\"\r\n";
+
+        auto rows = parse_static(csv_string);
+        REQUIRE(rows.size() == 101);
+        REQUIRE(rows[0] == std::vector<std::string>({ "A", "B,C" }));
+        REQUIRE(rows[100] == std::vector<std::string>({ "99,x", "\"y\"" }));
+    }
+
+    SECTION("Quoted Input") {
+        std::string csv_string = "A;B,C\r\n";
+        for (int i = 0; i < 100; i++)
+            csv_string += "'a;\nb';" + std::to_string(i) + ",x;'c,d'\r\n";
+
+        auto rows = parse_static(csv_string);
+        REQUIRE(rows.size() == 101);
+        REQUIRE(rows[100] == std::vector<std::string>({ "a;\nb", "99,x", "c,d" }));
+    }
+}
+
+namespace {
+    std::vector<std::vector<std::string>> parse_file_rows(const std::string& filename, size_t threads, size_t bytes,
+        bool whole_file = false) {
+        RowCollectionTest rows;
+        MmapParser parser(filename, CSVFormat().parse_threads(threads).map_whole_file(whole_file));
+        parser.set_output(rows);
+
+        while (!parser.eof())
+            parser.next(bytes);
+
+        std::vector<std::vector<std::string>> ret;
+        for (auto& row : rows) {
+            ret.push_back(std::vector<std::string>(row));
+        }
+
+        return ret;
+    }
+}
+
+TEST_CASE("Parallel MmapParser Matches Sequential", "[test_parallel_mmap]") {
+    const std::string filename = "parallel_mmap.csv";
+
+    // Well formed rows mixed with the occasional malformed quote
+    const std::string alphabet = "abcdef,,,\"\n\r";
+    std::mt19937 rng(1999);
+    std::string csv_string;
+    for (int i = 0; i < 2000; i++) {
+        if (i % 3 == 0) {
+            csv_string += "\"quoted,\n\"\"field\"\"\"," + std::to_string(i) + "\r\n";
+        }
+        else {
+            for (size_t j = rng() % 40; j > 0; j--)
+                csv_string += alphabet[rng() % alphabet.size()];
+            csv_string += '\n';
+        }
+    }
+
+    {
+        std::ofstream outfile(filename, std::ios::binary);
+        outfile << csv_string;
+    }
+
+    auto expected = parse_file_rows(filename, 1, csv_string.size());
+    REQUIRE(expected.size() > 2000);
+
+    // Files smaller than ITERATION_CHUNK_SIZE are read in one window
+    for (size_t threads : { 2, 3, 8, 64 }) {
+        REQUIRE(parse_file_rows(filename, threads, csv_string.size() / threads + 1) == expected);
+    }
+
+    remove(filename.c_str());
+}
+
+TEST_CASE("Parallel MmapParser Skips UTF-8 BOM", "[test_parallel_mmap_bom]") {
+    const std::string filename = "parallel_mmap_bom.csv";
+
+    // The first range never finishes its row, so parsing falls back to the sequential parser
+    for (std::string csv_string : {
+        "\xEF\xBB\xBF" "a,b",
+        "\xEF\xBB\xBF" "\"a\nb\",c",
+        "\xEF\xBB\xBF" "\"a\nb\",c\nd,e\n"
+    }) {
+        {
+            std::ofstream outfile(filename, std::ios::binary);
+            outfile << csv_string;
+        }
+
+        auto expected = parse_rows(csv_string.substr(3), WhitespaceMap());
+        for (size_t threads : { 1, 2, 4 }) {
+            INFO("Threads: " << threads);
+            REQUIRE(parse_file_rows(filename, threads, csv_string.size() / threads + 1) == expected);
+        }
+    }
+
+    remove(filename.c_str());
+}
+
+TEST_CASE("MmapParser Handles CRLF Split Between Windows", "[test_mmap_split_crlf]") {
+    const std::string filename = "split_crlf_mmap.csv";
+
+    // Larger than ITERATION_CHUNK_SIZE, so the file is read in more than one window.
+    // Every row is 11 characters long, so windows whose length is 10 more than a
+    // multiple of 11 always end between the CR and LF of a row.
+    std::string csv_string = "AAAAA,BBB\r\n";
+    for (int i = 0; i < 1000000; i++) {
+        csv_string += std::to_string(1000000 + i) + ",x\r\n";
+    }
+
+    {
+        std::ofstream outfile(filename, std::ios::binary);
+        outfile << csv_string;
+    }
+
+    auto expected = parse_file_rows(filename, 1, csv_string.size());
+    REQUIRE(expected.size() == 1000001);
+
+    REQUIRE(parse_file_rows(filename, 1, 11 * 6000 - 1) == expected);
+    REQUIRE(parse_file_rows(filename, 3, 11 * 2000 + 7) == expected);
+
+    remove(filename.c_str());
+}
+
+TEST_CASE("Whole File MmapParser Matches Windowed", "[test_whole_file_mmap]") {
+    const std::string filename = "whole_file_mmap.csv";
+
+    // Larger than ITERATION_CHUNK_SIZE, so the file is read in more than one window
+    std::string csv_string = "A,B,C\r\n";
+    for (int i = 0; i < 500000; i++) {
+        csv_string += std::to_string(i) + ",\"quoted\r\n" + std::to_string(i * 7) + "\",x\r\n";
+    }
+
+    {
+        std::ofstream outfile(filename, std::ios::binary);
+        outfile << csv_string;
+    }
+
+    auto expected = parse_file_rows(filename, 1, csv_string.size());
+    REQUIRE(expected.size() == 500001);
+
+    // Some of these windows end between the CR and LF of a row
+    for (size_t bytes : { 4096, 16384, 65536, 1000000 }) {
+        REQUIRE(parse_file_rows(filename, 1, bytes) == expected);
+        REQUIRE(parse_file_rows(filename, 1, bytes, true) == expected);
+        REQUIRE(parse_file_rows(filename, 4, bytes, true) == expected);
+    }
+
+    SECTION("Rows Outlive Released Chunks") {
+        RowCollectionTest rows;
+        MmapParser parser(filename, CSVFormat().map_whole_file(true, true));
+        parser.set_output(rows);
+
+        // Hold on to every 1000th row while the rest (and their chunks) are dropped
+        std::vector<CSVRow> kept;
+        size_t i = 0;
+        while (!parser.eof()) {
+            parser.next(8192);
+            while (!rows.empty()) {
+                auto row = rows.pop_front();
+                if (i++ % 1000 == 0) kept.push_back(row);
+            }
+        }
+
+        REQUIRE(i == 500001);
+        REQUIRE(kept.size() == 501);
+        for (size_t j = 1; j < kept.size(); j++) {
+            REQUIRE(std::vector<std::string>(kept[j]) == expected[(j * 1000)]);
+        }
+    }
+
+    remove(filename.c_str());
+}
+
+namespace {
+    /** A stream buffer which cannot seek and hands out a few characters at a time, like a pipe */
+    class PipeBuffer : public std::streambuf {
+    public:
+        PipeBuffer(const std::string& data) : _data(data) {}
+
+    protected:
+        int_type underflow() override {
+            if (_pos == _data.size())
+                return traits_type::eof();
+
+            char* begin = &_data[_pos];
+            const size_t length = std::min((size_t)13, _data.size() - _pos);
+            this->setg(begin, begin, begin + length);
+            _pos += length;
+            return traits_type::to_int_type(*begin);
+        }
+
+    private:
+        std::string _data;
+        size_t _pos = 0;
+    };
+}
+
+TEST_CASE("ForwardStreamParser Matches StreamParser", "[test_forward_stream]") {
+    std::string csv_string = "A,B,C\r\n";
+    for (int i = 0; i < 200; i++) {
+        csv_string += "\"multi\nline, \"\"quoted\"\"\"," + std::to_string(i) + ",\r\n";
+        csv_string += "x,y\n";
+    }
+    csv_string += "1,2,3";
+
+    const auto expected = parse_rows(csv_string, WhitespaceMap());
+    REQUIRE(expected.size() == 402);
+
+    // Rows longer than the chunk size are carried over several chunks
+    for (size_t bytes : { 1, 5, 64, 1000, 100000 }) {
+        PipeBuffer buffer(csv_string);
+        std::istream pipe(&buffer);
+        REQUIRE(pipe.tellg() == std::streampos(-1));
+
+        RowCollectionTest rows;
+        ForwardStreamParser parser(pipe, CSVFormat());
+        parser.set_output(rows);
+
+        while (!parser.eof())
+            parser.next(bytes);
+
+        std::vector<std::vector<std::string>> actual;
+        for (auto& row : rows) {
+            actual.push_back(std::vector<std::string>(row));
+        }
+
+        REQUIRE(actual == expected);
+    }
+}
+
+TEST_CASE("StreamParser Recycles Chunks", "[test_stream_recycle]") {
+    std::string csv_string;
+    for (int i = 0; i < 500; i++) {
+        csv_string += "\"quoted\n" + std::to_string(i) + "\",x,y\r\n";
+    }
+
+    const auto expected = parse_rows(csv_string, WhitespaceMap());
+    REQUIRE(expected.size() == 500);
+
+    // Consuming rows as they are parsed lets earlier chunk buffers be reused
+    for (size_t bytes : { 3, 50, 777 }) {
+        std::stringstream source(csv_string);
+        RowCollectionTest rows;
+        StreamParser<std::stringstream> parser(source, internals::make_parse_flags(',', '"'), WhitespaceMap());
+        parser.set_output(rows);
+
+        std::vector<std::vector<std::string>> actual;
+        while (!parser.eof()) {
+            parser.next(bytes);
+            while (!rows.empty()) {
+                actual.push_back(std::vector<std::string>(rows.front()));
+                rows.pop_front();
+            }
+        }
+
+        REQUIRE(actual == expected);
+        REQUIRE(parser.recycled_chunks() > 0);
+    }
+}
+
+TEST_CASE("StringViewParser Matches StreamParser", "[test_string_view_parser]") {
+    std::string csv_string = "A,B,C\r\n";
+    for (int i = 0; i < 100; i++) {
+        csv_string += "\"a much longer row which spans many chunks\nwith a newline\",";
+        csv_string += std::to_string(i) + ",\r\n";
+    }
+
+    const auto expected = parse_rows(csv_string, WhitespaceMap());
+    REQUIRE(expected.size() == 101);
+
+    for (size_t bytes : { 1, 4, 60, 1000 }) {
+        RowCollectionTest rows;
+        StringViewParser parser(csv_string, CSVFormat());
+        parser.set_output(rows);
+
+        while (!parser.eof())
+            parser.next(bytes);
+
+        std::vector<std::vector<std::string>> actual;
+        for (auto& row : rows) {
+            actual.push_back(std::vector<std::string>(row));
+        }
+
+        REQUIRE(actual == expected);
+    }
+}
+
+TEST_CASE("StringViewParser Handles Newline Runs Longer Than a Chunk", "[test_string_view_newline_runs]") {
+    const std::vector<std::string> csv_strings = {
+        "abc\n\n\n\n\n\n\nb\n",
+        "\n\r\n",
+        "a\r\n\r\nb\n",
+        "a,b\r\n\r\n\r\n\r\n\r\n\r\nc,d\r\n\n\n\n\n\n\n\n\n\n",
+        "\"x\ny\",z\n\n\n\n\n\n\n\n\n\n\n\n1,2"
+    };
+
+    for (auto& csv_string : csv_strings) {
+        const auto expected = parse_rows(csv_string, WhitespaceMap());
+
+        for (size_t bytes = 1; bytes <= 10; bytes++) {
+            RowCollectionTest rows;
+            StringViewParser parser(csv_string, CSVFormat());
+            parser.set_output(rows);
+
+            while (!parser.eof())
+                parser.next(bytes);
+
+            std::vector<std::vector<std::string>> actual;
+            for (auto& row : rows) {
+                actual.push_back(std::vector<std::string>(row));
+            }
+
+            REQUIRE(actual == expected);
+        }
+    }
+}
+
+namespace {
+    std::vector<std::vector<std::string>> parse_chunked(const std::string& csv_string, const WhitespaceMap& ws_flags,
+        size_t bytes) {
+        std::stringstream source(csv_string);
+        RowCollectionTest rows;
+        StreamParser<std::stringstream> parser(source, internals::make_parse_flags(',', '"'), ws_flags);
+        parser.set_output(rows);
+
+        while (!parser.eof())
+            parser.next(bytes);
+
+        std::vector<std::vector<std::string>> ret;
+        for (auto& row : rows) {
+            ret.push_back(std::vector<std::string>(row));
+        }
+
+        return ret;
+    }
+}
+
+TEST_CASE("Chunked Parsing Resumes Partial Rows", "[test_resume_row]") {
+    const auto trim = internals::make_ws_flags({ ' ' });
+
+    SECTION("Chunks Ending Anywhere") {
+        // Every kind of state a chunk can end in: Inside quotes, after a quote,
+        // inside an escaped quote, before or after a delimiter, inside whitespace...
+        const std::string alphabet = "ab ,,\"\"\"\n\r";
+        std::mt19937 rng(16);
+
+        for (int i = 0; i < 300; i++) {
+            std::string csv_string = (i % 2) ? "\xEF\xBB\xBF" : "";
+            for (size_t j = rng() % 200; j > 0; j--)
+                csv_string += alphabet[rng() % alphabet.size()];
+
+            for (auto& ws_flags : { WhitespaceMap(), trim }) {
+                const auto expected = parse_rows(csv_string, ws_flags);
+                for (size_t bytes : { 1, 2, 3, 7, 16 })
+                    REQUIRE(parse_chunked(csv_string, ws_flags, bytes) == expected);
+            }
+        }
+    }
+
+    SECTION("Rows Much Longer Than a Chunk") {
+        std::string row;
+        for (int i = 0; i < 20000; i++)
+            row += "\"field " + std::to_string(i) + " \"\"quoted\"\"\",";
+        row += "last";
+
+        const std::string csv_string = row + "\r\n" + row + "\r\n1,2\r\n";
+        const auto rows = parse_chunked(csv_string, WhitespaceMap(), 10);
+        REQUIRE(rows.size() == 3);
+        REQUIRE(rows[0].size() == 20001);
+        REQUIRE(rows[0][19999] == "field 19999 \"quoted\"");
+        REQUIRE(rows[1] == rows[0]);
+        REQUIRE(rows[2] == std::vector<std::string>({ "1", "2" }));
+    }
+}
+
+TEST_CASE("RowBatchQueue Preserves Order", "[test_row_batch_queue]") {
+    std::string csv_string;
+    for (int i = 0; i < 100000; i++)
+        csv_string += std::to_string(i) + ",x\n";
+
+    // A ring of two batches fills up quickly, so batches spill over and come back
+    for (size_t capacity : { 2, 256 }) {
+        RowBatchQueue rows(capacity);
+        StringViewParser parser(csv_string, CSVFormat());
+        parser.set_output(rows);
+
+        rows.notify_all();
+        std::thread producer([&] {
+            while (!parser.eof())
+                parser.next(4096);
+
+            rows.kill_all();
+        });
+
+        int expected = 0;
+        bool in_order = true;
+        while (true) {
+            if (rows.empty()) {
+                if (!rows.is_waitable() && rows.empty()) break;
+                rows.wait();
+                continue;
+            }
+
+            auto row = rows.pop_front();
+            in_order = in_order && row[0].get<int>() == expected;
+            expected++;
+        }
+
+        producer.join();
+        REQUIRE(in_order);
+        REQUIRE(expected == 100000);
+    }
+}
@@ -419,6 +419,51 @@ TEST_CASE("Test Variable Row Length Handling", "[read_csv_var_len]") {
     }
 }
 
+TEST_CASE("Test Reading Rows in Batches", "[read_csv_read_rows]") {
+    string csv_string("A,B,C\r\n"
+        "123,234,345\r\n"
+        "1,2,3\r\n"
+        "6,9\r\n" // Short row
+        "4,5,6\r\n");
+
+    RowBatch batch;
+
+    SECTION("Ignore Row") {
+        auto reader = parse(csv_string, CSVFormat());
+        REQUIRE(reader.read_rows(batch, 100));
+        REQUIRE(batch.size() == 3);
+        REQUIRE(batch[0]["A"] == "123");
+        REQUIRE(batch[2]["C"] == "6");
+        REQUIRE(reader.n_rows() == 3);
+
+        REQUIRE_FALSE(reader.read_rows(batch, 100));
+        REQUIRE(batch.empty());
+    }
+
+    SECTION("Batches Smaller Than the CSV") {
+        auto reader = parse(csv_string, CSVFormat());
+        vector<string> first_column;
+        while (reader.read_rows(batch, 2)) {
+            REQUIRE(batch.size() <= 2);
+            for (auto& row : batch)
+                first_column.push_back(row[0].get<string>());
+        }
+
+        REQUIRE(first_column == vector<string>({ "123", "1", "4" }));
+    }
+
+    SECTION("Throw Error") {
+        CSVFormat format;
+        format.variable_columns(VariableColumnPolicy::THROW);
+
+        // Rows before the error are returned first
+        auto reader = parse(csv_string, format);
+        REQUIRE(reader.read_rows(batch, 100));
+        REQUIRE(batch.size() == 2);
+        REQUIRE_THROWS_WITH(reader.read_rows(batch, 100), Catch::Matchers::StartsWith("Line too short"));
+    }
+}
+
 TEST_CASE("Test read_row() CSVField - Memory", "[read_row_csvf2]") {
     CSVFormat format;
     format.column_names({ "A", "B" });
@@ -605,3 +650,301 @@ TEST_CASE("Empty CSV", "[read_empty_csv]") {
         REQUIRE(reader.n_rows() == 0);
     }
 }
+
+template<typename TFormat>
+std::vector<std::vector<std::string>> read_all(const std::string& csv_string, const TFormat& format) {
+    std::stringstream source(csv_string);
+    CSVReader reader(source, format);
+
+    std::vector<std::vector<std::string>> rows;
+    for (auto& row : reader)
+        rows.push_back(std::vector<std::string>(row));
+
+    return rows;
+}
+
+TEST_CASE("Static Dialect Matches Runtime Dialect", "[read_csv_static_dialect]") {
+    auto csv_string = GENERATE(as<std::string>{},
+        "A,B,C\r\n"
+        "123,\"234\n,345\",456\r\n"
+        "1,2,3\r\n",
+
+        // Escaped and unescaped quotes
+        "A,B,C\n"
+        "\"\"\"quoted\"\"\",x\"y\"z,\"\"\n"
+        "\"unterminated\"junk,,\"a\"\"\n",
+
+        // Empty fields and trailing delimiter
+        "A,B,C\n"
+        ",,\n"
+        "1,,3,\n"
+        "4,5,6"
+    );
+
+    SECTION("RFC 4180") {
+        CSVFormat runtime_format;
+        runtime_format.variable_columns(VariableColumnPolicy::KEEP);
+        RFC4180Format static_format;
+        static_format.variable_columns(VariableColumnPolicy::KEEP);
+
+        REQUIRE(read_all(csv_string, static_format) == read_all(csv_string, runtime_format));
+    }
+
+    SECTION("Quoting Disabled") {
+        CSVFormat runtime_format;
+        runtime_format.quote(false).variable_columns(VariableColumnPolicy::KEEP);
+        StaticCSVFormat<',', '"', false> static_format;
+        static_format.variable_columns(VariableColumnPolicy::KEEP);
+
+        REQUIRE(read_all(csv_string, static_format) == read_all(csv_string, runtime_format));
+    }
+}
+
+TEST_CASE("Static Dialect Falls Back on Changed Settings", "[read_csv_static_dialect_fallback]") {
+    StaticCSVFormat<';', '\''> format;
+    REQUIRE(format.is_static_dialect());
+
+    auto rows = read_all("A;B\n'x;y';2\n", format);
+    REQUIRE(rows[0] == vector<string>({ "x;y", "2" }));
+
+    format.trim({ ' ' });
+    REQUIRE_FALSE(format.is_static_dialect());
+
+    rows = read_all("A;B\n'x;y';  2 \n", format);
+    REQUIRE(rows[0] == vector<string>({ "x;y", "2" }));
+}
+
+TEST_CASE("Test Column Selection", "[read_csv_select_columns]") {
+    std::string csv_string = "A,B,C,D\r\n"
+        "1,\"two, \"\"2\"\"\",3,4\r\n"
+        "5,6,7,8\r\n";
+
+    SECTION("By Name") {
+        CSVFormat format;
+        format.select_columns({ "D", "B" });
+        std::stringstream source(csv_string);
+        CSVReader reader(source, format);
+
+        // Columns are returned in file order
+        REQUIRE(reader.get_col_names() == vector<string>({ "B", "D" }));
+
+        CSVRow row;
+        reader.read_row(row);
+        REQUIRE(vector<string>(row) == vector<string>({ "two, \"2\"", "4" }));
+        REQUIRE(row["D"] == 4);
+
+        reader.read_row(row);
+        REQUIRE(vector<string>(row) == vector<string>({ "6", "8" }));
+        REQUIRE_FALSE(reader.read_row(row));
+    }
+
+    SECTION("By Index") {
+        CSVFormat format;
+        format.select_columns({ 0 });
+
+        auto rows = read_all(csv_string, format);
+        REQUIRE(rows == vector<vector<string>>({ { "1" }, { "5" } }));
+    }
+
+    SECTION("With Column Names") {
+        CSVFormat format;
+        format.column_names({ "W", "X", "Y", "Z" }).select_columns({ "Y" });
+        std::stringstream source(csv_string);
+        CSVReader reader(source, format);
+        REQUIRE(reader.get_col_names() == vector<string>({ "Y" }));
+
+        vector<string> values;
+        for (auto& row : reader)
+            values.push_back(row["Y"].get<string>());
+
+        REQUIRE(values == vector<string>({ "C", "3", "7" }));
+    }
+
+    SECTION("Missing Column") {
+        CSVFormat format;
+        format.select_columns({ "E" });
+        std::stringstream source(csv_string);
+        REQUIRE_THROWS(CSVReader(source, format));
+    }
+}
+
+TEST_CASE("Test Column Selection w/ Variable Row Lengths", "[read_csv_select_columns_var_len]") {
+    std::string csv_string = "A,B,C\n"
+        "1,2,3\n"
+        "4,5,6,7\n"
+        "8,9\n"
+        "10,11,12\n";
+
+    CSVFormat format;
+    format.select_columns({ "A", "B" });
+
+    SECTION("Ignore") {
+        auto rows = read_all(csv_string, format);
+        REQUIRE(rows == vector<vector<string>>({ { "1", "2" }, { "10", "11" } }));
+    }
+
+    SECTION("Keep") {
+        format.variable_columns(VariableColumnPolicy::KEEP);
+        auto rows = read_all(csv_string, format);
+        REQUIRE(rows.size() == 4);
+        REQUIRE(rows[2] == vector<string>({ "8", "9" }));
+    }
+
+    SECTION("Throw") {
+        format.variable_columns(VariableColumnPolicy::THROW);
+        std::stringstream source(csv_string);
+        CSVReader reader(source, format);
+
+        CSVRow row;
+        REQUIRE(reader.read_row(row));
+        REQUIRE_THROWS_WITH(reader.read_row(row), Catch::Matchers::StartsWith("Line too long"));
+    }
+}
+
+TEST_CASE("Test Column Selection Skips Unselected Fields", "[read_csv_select_columns_skip]") {
+    // Unselected fields contain quotes which are not special, delimiters inside
+    // quotes, and whitespace to trim
+    std::string csv_string = "A,B,C,D\r\n"
+        "  1 ,x\"y\"z,\"p,\"\"q\"\"\",4\r\n"
+        "5, \"6,6\",7,8\r\n";
+
+    CSVFormat format;
+    format.select_columns({ "A", "D" });
+
+    SECTION("State Machine") {
+        // Trimming is only handled by the state machine
+        format.trim({ ' ' });
+        auto rows = read_all(csv_string, format);
+        REQUIRE(rows == vector<vector<string>>({ { "1", "4" }, { "5", "8" } }));
+    }
+
+    SECTION("Trailing Columns") {
+        // Without quotes, fields after the last selected column are only counted
+        csv_string = "A,B,C,D\n1,2,3,4\n5,6,7,8,9\n10,11,12\n13,14,15,16\n";
+        format.select_columns({ "B" });
+
+        auto rows = read_all(csv_string, format);
+        REQUIRE(rows == vector<vector<string>>({ { "2" }, { "14" } }));
+
+        format.variable_columns(VariableColumnPolicy::THROW);
+        std::stringstream source(csv_string);
+        CSVReader reader(source, format);
+
+        CSVRow row;
+        REQUIRE(reader.read_row(row));
+        REQUIRE_THROWS_WITH(reader.read_row(row), Catch::Matchers::StartsWith("Line too long"));
+    }
+}
+
+TEST_CASE("Test Row Filters", "[read_csv_filter]") {
+    std::string csv_string = "Name,Age,City\r\n"
+        "Alice,34,Boston\r\n"
+        "Bob,n/a,Berlin\r\n"
+        "Carol,27,Bern\r\n"
+        "Dave,45,Chicago\r\n";
+
+    auto names = [](const std::string& csv_string, const CSVFormat& format) {
+        vector<string> ret;
+        for (auto& row : read_all(csv_string, format))
+            ret.push_back(row[0]);
+
+        return ret;
+    };
+
+    SECTION("Equals") {
+        CSVFormat format;
+        format.filter(column_equals("City", "Bern"));
+        REQUIRE(names(csv_string, format) == vector<string>({ "Carol" }));
+    }
+
+    SECTION("Between") {
+        CSVFormat format;
+        format.filter(column_between("Age", 30, 45));
+        REQUIRE(names(csv_string, format) == vector<string>({ "Alice", "Dave" }));
+    }
+
+    SECTION("Multiple Filters") {
+        CSVFormat format;
+        format.filter(column_starts_with("City", "B"))
+            .filter([](const CSVRow& row) { return !(row["Name"] == "Alice"); });
+        REQUIRE(names(csv_string, format) == vector<string>({ "Bob", "Carol" }));
+    }
+
+    SECTION("With Column Selection") {
+        CSVFormat format;
+        format.select_columns({ "Name", "City" })
+            .filter(column_starts_with("City", "Ber"));
+        REQUIRE(names(csv_string, format) == vector<string>({ "Bob", "Carol" }));
+    }
+
+    SECTION("Rows Read Count") {
+        CSVFormat format;
+        format.filter(column_equals("Name", "Dave"));
+        std::stringstream source(csv_string);
+        CSVReader reader(source, format);
+
+        for (auto& row : reader)
+            REQUIRE(row["Age"] == 45);
+
+        REQUIRE(reader.n_rows() == 1);
+        REQUIRE(reader.get_col_names() == vector<string>({ "Name", "Age", "City" }));
+    }
+
+    SECTION("Filter Throws") {
+        CSVFormat format;
+        format.filter([](const CSVRow& row) { return row["Age"].get<int>() > 0; });
+        std::stringstream source(csv_string);
+        CSVReader reader(source, format);
+
+        CSVRow row;
+        REQUIRE(reader.read_row(row));
+        REQUIRE(row["Name"] == "Alice");
+        REQUIRE_THROWS(reader.read_row(row));
+    }
+}
+
+TEST_CASE("Test Reading From std::istream", "[read_csv_istream]") {
+    std::stringbuf buffer("A,B,C\r\n"
+        "1,2,3\r\n"
+        "\"4\n\",5,6\r\n"
+        "7,8,9");
+    std::istream source(&buffer);
+
+    CSVReader reader(source);
+    std::vector<std::string> first_col;
+    for (auto& row : reader) {
+        first_col.push_back(row["A"].get<std::string>());
+    }
+
+    REQUIRE(reader.get_col_names() == std::vector<std::string>({ "A", "B", "C" }));
+    REQUIRE(first_col == std::vector<std::string>({ "1", "4\n", "7" }));
+}
+
+TEST_CASE("Test Parsing Memory In Place", "[read_csv_in_memory]") {
+    // Only the first part of this buffer is CSV data, and it isn't null terminated
+    const std::string buffer = "A,B,C\r\n"
+        "1,\"2\n\",3\r\n"
+        "4,5,6"
+        "7,8,9\r\n";
+    const csv::string_view data(buffer.data(), buffer.size() - 7);
+
+    CSVReader reader(csv::in_memory, data);
+    std::vector<CSVRow> rows(reader.begin(), reader.end());
+
+    REQUIRE(reader.get_col_names() == std::vector<std::string>({ "A", "B", "C" }));
+    REQUIRE(rows.size() == 2);
+    REQUIRE(rows[0]["B"] == "2\n");
+    REQUIRE(rows[1]["C"] == "6");
+
+    // Fields point into the original buffer
+    auto field = rows[1]["A"].get<csv::string_view>();
+    REQUIRE(field.data() == buffer.data() + buffer.find('4'));
+
+    SECTION("parse() copies its input") {
+        auto copied = parse(data);
+        std::vector<CSVRow> copied_rows(copied.begin(), copied.end());
+        REQUIRE(copied_rows.size() == 2);
+        REQUIRE(copied_rows[1]["C"] == "6");
+        REQUIRE(copied_rows[1]["A"].get<csv::string_view>().data() != field.data());
+    }
+}
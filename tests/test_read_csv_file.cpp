@@ -3,10 +3,29 @@
  */
 
 #include <stdio.h> // remove()
+#include <atomic>
+#include <fstream>
+#include <random>
 #include <sstream>
 #include <catch2/catch_all.hpp>
 #include "csv.hpp"
 
+#ifdef CSV_HAS_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef CSV_HAS_ZSTD
+#include <zstd.h>
+#endif
+
+#ifdef CSV_HAS_COROUTINES
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <future>
+#include <mutex>
+#endif
+
 using namespace csv;
 using std::vector;
 using std::string;
@@ -63,6 +82,617 @@ TEST_CASE("get_file_info() Test", "[test_file_info]") {
     }
 }
 
+// count_rows()
+TEST_CASE("count_rows() Matches CSVReader", "[test_count_rows]") {
+    const std::string filename = "count_rows.csv";
+
+    // Rows of varying length with quoted newlines, blank lines and mixed line endings
+    std::mt19937 rng(808);
+    std::string csv_string = "\xEF\xBB\xBF" "A,B,C\r\n";
+    for (int i = 0; i < 3000; i++) {
+        const size_t n_fields = (rng() % 10 == 0) ? rng() % 5 + 1 : 3;
+        for (size_t j = 0; j < n_fields; j++) {
+            if (j > 0) csv_string += ',';
+
+            switch (rng() % 4) {
+            case 0:
+                csv_string += "\"a,\nb\"\"c\r\n\"";
+                break;
+            case 1:
+                break;
+            default:
+                csv_string += std::to_string(rng() % 1000);
+            }
+        }
+
+        csv_string += (rng() % 2) ? "\r\n" : "\n";
+        if (rng() % 50 == 0) csv_string += "\n\n";
+    }
+
+    {
+        std::ofstream outfile(filename, std::ios::binary);
+        outfile << csv_string;
+    }
+
+    SECTION("Default Policy") {
+        CSVReader reader(filename);
+        for (auto& row : reader) { (void)row; }
+        REQUIRE(reader.n_rows() < 3000);
+        REQUIRE(count_rows(filename) == reader.n_rows());
+
+        for (size_t threads : { 1, 2, 3, 8, 64 }) {
+            REQUIRE(internals::count_rows(csv_string, reader.get_format(), threads) == reader.n_rows());
+        }
+    }
+
+    SECTION("Keep Variable Length Rows") {
+        CSVFormat format;
+        format.variable_columns(VariableColumnPolicy::KEEP);
+        CSVReader reader(filename, format);
+        for (auto& row : reader) { (void)row; }
+        // Single empty fields are blank lines, which are skipped
+        REQUIRE(reader.n_rows() > 2950);
+        REQUIRE(count_rows(filename, format) == reader.n_rows());
+
+        for (size_t threads : { 2, 7, 16 }) {
+            REQUIRE(internals::count_rows(csv_string, format, threads) == reader.n_rows());
+        }
+    }
+
+    remove(filename.c_str());
+}
+
+namespace {
+    vector<vector<string>> read_rows(CSVReader& reader) {
+        vector<vector<string>> rows;
+        for (auto& row : reader) {
+            rows.push_back(vector<string>(row));
+        }
+
+        return rows;
+    }
+
+    /** About 3MB of CSV data, so that it is decompressed in several blocks */
+    string compressible_csv() {
+        string csv_string = "A,B,C\r\n";
+        for (int i = 0; i < 100000; i++) {
+            csv_string += std::to_string(i) + ",\"quoted\n" + std::to_string(i % 7) + "\",xyz\r\n";
+        }
+
+        return csv_string;
+    }
+}
+
+TEST_CASE("Read Compressed CSV", "[read_csv_compressed]") {
+    const string csv_string = compressible_csv();
+    const string plain_file = "compressed_plain.csv";
+    {
+        std::ofstream outfile(plain_file, std::ios::binary);
+        outfile << csv_string;
+    }
+
+    CSVReader plain_reader(plain_file);
+    auto expected = read_rows(plain_reader);
+    REQUIRE(expected.size() == 100000);
+
+#ifdef CSV_HAS_ZLIB
+    SECTION("gzip") {
+        const string filename = "compressed.csv.gz";
+
+        // Write two gzip members, which should be read back to back
+        const size_t half = csv_string.size() / 2;
+        for (int member = 0; member < 2; member++) {
+            gzFile file = gzopen(filename.c_str(), member == 0 ? "wb" : "ab");
+            const string part = member == 0 ? csv_string.substr(0, half) : csv_string.substr(half);
+            gzwrite(file, part.data(), (unsigned)part.size());
+            gzclose(file);
+        }
+
+        CSVReader reader(filename);
+        REQUIRE(reader.get_format().get_delim() == ',');
+        REQUIRE(read_rows(reader) == expected);
+        REQUIRE(count_rows(filename) == 100000);
+
+        remove(filename.c_str());
+    }
+#endif
+
+#ifdef CSV_HAS_ZSTD
+    SECTION("zstd") {
+        const string filename = "compressed.csv.zst";
+
+        string compressed(ZSTD_compressBound(csv_string.size()), '\0');
+        compressed.resize(ZSTD_compress(&compressed[0], compressed.size(),
+            csv_string.data(), csv_string.size(), 1));
+        {
+            std::ofstream outfile(filename, std::ios::binary);
+            outfile << compressed;
+        }
+
+        CSVReader reader(filename);
+        REQUIRE(read_rows(reader) == expected);
+
+        remove(filename.c_str());
+    }
+#endif
+
+    SECTION("Truncated or Unsupported") {
+        const string filename = "truncated.csv.gz";
+        {
+            // A gzip header without any compressed data
+            std::ofstream outfile(filename, std::ios::binary);
+            outfile << "\x1F\x8B\x08\x00\x00\x00\x00\x00\x00\x03";
+        }
+
+        bool error_caught = false;
+        try {
+            CSVReader reader(filename, CSVFormat());
+            read_rows(reader);
+        }
+        catch (std::runtime_error&) {
+            error_caught = true;
+        }
+
+        REQUIRE(error_caught);
+        remove(filename.c_str());
+    }
+
+    remove(plain_file.c_str());
+}
+
+TEST_CASE("Read CSV with pread()", "[read_csv_pread]") {
+    // Several times larger than a read, so blocks get recycled
+    string csv_string = compressible_csv();
+    const string body = csv_string.substr(csv_string.find('\n') + 1);
+    for (int i = 0; i < 4; i++)
+        csv_string += body;
+
+    const string filename = "pread.csv";
+    {
+        std::ofstream outfile(filename, std::ios::binary);
+        outfile << csv_string;
+    }
+
+    CSVReader mmap_reader(filename);
+    auto expected = read_rows(mmap_reader);
+    REQUIRE(expected.size() == 500000);
+
+    for (size_t depth : { 1, 2, 8 }) {
+        for (bool direct_io : { false, true }) {
+            CSVFormat format;
+            format.read_with_pread(depth, direct_io);
+
+            CSVReader reader(filename, format);
+            REQUIRE(read_rows(reader) == expected);
+        }
+    }
+
+    SECTION("Rows Longer Than a Chunk") {
+        // Rows which do not fit in front of the next block are copied
+        const string long_filename = "pread_long_rows.csv";
+        string long_csv = "A,B\r\n";
+        for (int i = 0; i < 200; i++) {
+            const size_t length = i % 10 == 0 ? 100000 : (size_t)i * 37;
+            long_csv += std::to_string(i) + ",\"" + string(length, i % 2 ? 'x' : '\n') + "\"\r\n";
+        }
+
+        {
+            std::ofstream outfile(long_filename, std::ios::binary);
+            outfile << long_csv;
+        }
+
+        CSVReader long_mmap_reader(long_filename);
+        auto long_expected = read_rows(long_mmap_reader);
+        REQUIRE(long_expected.size() == 200);
+
+        for (size_t chunk_size : { 1 << 10, 1 << 14, 1 << 18 }) {
+            CSVFormat format;
+            format.read_with_pread(2).chunk_size(chunk_size);
+
+            CSVReader reader(long_filename, format);
+            REQUIRE(read_rows(reader) == long_expected);
+        }
+
+        remove(long_filename.c_str());
+    }
+
+    SECTION("Readers Destroyed Early") {
+        CSVFormat format;
+        format.read_with_pread(1);
+
+        CSVReader reader(filename, format);
+        CSVRow row;
+        REQUIRE(reader.read_row(row));
+        REQUIRE(row["A"] == "0");
+    }
+
+    remove(filename.c_str());
+}
+
+TEST_CASE("Read CSV with Custom Chunk Sizes", "[read_csv_chunk_size]") {
+    const string csv_string = compressible_csv();
+    const string filename = "chunk_size.csv";
+    {
+        std::ofstream outfile(filename, std::ios::binary);
+        outfile << csv_string;
+    }
+
+    CSVReader default_reader(filename);
+    REQUIRE(default_reader.chunk_size() == internals::ITERATION_CHUNK_SIZE);
+    auto expected = read_rows(default_reader);
+    REQUIRE(expected.size() == 100000);
+
+    SECTION("Fixed Chunk Size") {
+        CSVFormat format;
+        format.chunk_size(1 << 16);
+
+        CSVReader reader(filename, format);
+        REQUIRE(reader.chunk_size() == 1 << 16);
+        REQUIRE(read_rows(reader) == expected);
+
+        std::ifstream infile(filename, std::ios::binary);
+        CSVReader stream_reader(infile, format);
+        REQUIRE(read_rows(stream_reader) == expected);
+    }
+
+    SECTION("Adaptive Chunk Size") {
+        const size_t memory_limit = 1 << 22,
+            min_bytes = 1 << 14,
+            max_bytes = 1 << 20;
+
+        CSVFormat format;
+        format.chunk_size(min_bytes).adaptive_chunk_size(memory_limit, min_bytes, max_bytes);
+
+        CSVReader reader(filename, format);
+        REQUIRE(read_rows(reader) == expected);
+
+        // Rows are small and read as fast as they are parsed, so chunks should have grown
+        REQUIRE(reader.chunk_size() > min_bytes);
+        REQUIRE(reader.chunk_size() <= max_bytes);
+
+        // Rows of about 20 bytes with 3 fields each take up several times the size of the CSV
+        REQUIRE(reader.chunk_size() < memory_limit / 4);
+    }
+
+    remove(filename.c_str());
+}
+
+TEST_CASE("Read CSV with Chunks Smaller Than the Header", "[read_csv_chunk_size_header]") {
+    const string csv_string = "A,B\n1,2\n3,4\n5,6\n";
+    const string filename = "chunk_size_header.csv";
+    {
+        std::ofstream outfile(filename, std::ios::binary);
+        outfile << csv_string;
+    }
+
+    const vector<vector<string>> expected = { { "1", "2" }, { "3", "4" }, { "5", "6" } };
+    for (size_t bytes = 1; bytes <= 5; bytes++) {
+        INFO("Chunk size: " << bytes);
+        CSVFormat format;
+        format.chunk_size(bytes);
+
+        CSVReader reader(filename, format);
+        REQUIRE(reader.get_col_names() == vector<string>({ "A", "B" }));
+        REQUIRE(read_rows(reader) == expected);
+
+        CSVReader memory_reader(csv::in_memory, csv_string, format);
+        REQUIRE(memory_reader.get_col_names() == vector<string>({ "A", "B" }));
+        REQUIRE(read_rows(memory_reader) == expected);
+    }
+
+    remove(filename.c_str());
+}
+
+TEST_CASE("Read CSV Ahead of the Consumer", "[read_csv_read_ahead]") {
+    const string csv_string = compressible_csv();
+    const string filename = "read_ahead.csv";
+    {
+        std::ofstream outfile(filename, std::ios::binary);
+        outfile << csv_string;
+    }
+
+    CSVReader default_reader(filename);
+    auto expected = read_rows(default_reader);
+
+    for (size_t depth : { 1, 2, 8 }) {
+        CSVFormat format;
+        format.chunk_size(1 << 14).read_ahead(depth);
+
+        CSVReader reader(filename, format);
+        REQUIRE(read_rows(reader) == expected);
+    }
+
+    SECTION("Read Rows in Batches") {
+        CSVFormat format;
+        format.chunk_size(1 << 14);
+
+        CSVReader reader(filename, format);
+        vector<vector<string>> rows;
+        RowBatch batch;
+        while (reader.read_rows(batch, 1000)) {
+            REQUIRE(batch.size() <= 1000);
+            for (auto& row : batch)
+                rows.push_back(vector<string>(row));
+        }
+
+        REQUIRE(rows == expected);
+        REQUIRE(reader.n_rows() == expected.size());
+    }
+
+    SECTION("Readers Destroyed While Parsing Ahead") {
+        CSVFormat format;
+        format.chunk_size(1 << 12).read_ahead(1);
+
+        CSVReader reader(filename, format);
+        CSVRow row;
+        REQUIRE(reader.read_row(row));
+        REQUIRE(row["A"] == "0");
+    }
+
+    remove(filename.c_str());
+}
+
+TEST_CASE("Process Rows in Parallel", "[read_csv_parallel]") {
+    const string csv_string = compressible_csv();
+    const string filename = "parallel.csv";
+    {
+        std::ofstream outfile(filename, std::ios::binary);
+        outfile << csv_string;
+    }
+
+    CSVFormat format;
+    format.chunk_size(1 << 16);
+
+    SECTION("parallel_for_each()") {
+        for (size_t n_threads : { 1, 4 }) {
+            Executor executor(n_threads);
+            CSVReader reader(filename, CSVFormat(format).executor(executor));
+            std::atomic<long long> sum{ 0 };
+            std::atomic<size_t> count{ 0 };
+
+            reader.parallel_for_each([&](const CSVRow& row) {
+                sum += row["A"].get<long long>();
+                count++;
+            });
+
+            REQUIRE(count == 100000);
+            REQUIRE(sum == 99999LL * 100000LL / 2);
+        }
+    }
+
+    SECTION("Ordered parallel_map_reduce()") {
+        CSVReader default_reader(filename);
+        string expected;
+        for (auto& row : default_reader)
+            expected += row["A"].get<string>() + ";";
+
+        CSVReader reader(filename, format);
+        auto result = reader.parallel_map_reduce(
+            [](const CSVRow& row) { return row["A"].get<string>() + ";"; },
+            [](string a, const string& b) { return a + b; },
+            string(), 4, true);
+
+        REQUIRE(result == expected);
+    }
+
+    SECTION("Exceptions Propagate") {
+        CSVReader reader(filename, format);
+        bool error_caught = false;
+        try {
+            reader.parallel_for_each([](const CSVRow& row) {
+                if (row["A"].get<int>() == 54321)
+                    throw std::runtime_error("Bad row");
+            }, 4);
+        }
+        catch (std::runtime_error& err) {
+            error_caught = true;
+            REQUIRE(string(err.what()) == "Bad row");
+        }
+
+        REQUIRE(error_caught);
+    }
+
+    remove(filename.c_str());
+}
+
+TEST_CASE("Readers Sharing an Executor", "[read_csv_executor]") {
+    const string csv_string = compressible_csv();
+    const string filename = "executor.csv";
+    {
+        std::ofstream outfile(filename, std::ios::binary);
+        outfile << csv_string;
+    }
+
+    CSVReader default_reader(filename);
+    auto expected = read_rows(default_reader);
+
+    // Many more readers and parsing ranges than threads
+    Executor executor(2);
+    CSVFormat format;
+    format.chunk_size(1 << 14).parse_threads(3).executor(executor);
+
+    vector<std::unique_ptr<CSVReader>> readers;
+    vector<vector<vector<string>>> rows(16);
+    for (size_t i = 0; i < rows.size(); i++)
+        readers.push_back(std::unique_ptr<CSVReader>(new CSVReader(filename, format)));
+
+    // Read the files in turns, so every reader has to parse ahead and resume
+    for (bool done = false; !done; ) {
+        done = true;
+        for (size_t i = 0; i < readers.size(); i++) {
+            RowBatch batch;
+            if (readers[i]->read_rows(batch, 5000)) {
+                done = false;
+                for (auto& row : batch)
+                    rows[i].push_back(vector<string>(row));
+            }
+        }
+    }
+
+    for (auto& reader_rows : rows)
+        REQUIRE(reader_rows == expected);
+
+    REQUIRE(count_rows(filename, format) == expected.size());
+
+    remove(filename.c_str());
+}
+
+TEST_CASE("Nested Readers on a Single Thread", "[read_csv_executor_nested]") {
+    const string csv_string = compressible_csv();
+    const string filename = "executor_nested.csv";
+    {
+        std::ofstream outfile(filename, std::ios::binary);
+        outfile << csv_string;
+    }
+
+    string inner_csv = "A,B\r\n";
+    for (int i = 0; i < 5000; i++)
+        inner_csv += std::to_string(i) + ",x\r\n";
+
+    // The only thread runs `fn`, so parsing ahead for the inner readers and
+    // the outer reader's batches have to be run by whoever is waiting for them
+    Executor executor(1);
+    CSVFormat format;
+    format.chunk_size(1 << 12).executor(executor);
+
+    CSVReader reader(filename, format);
+    std::atomic<size_t> outer_rows{ 0 }, inner_rows{ 0 };
+
+    reader.parallel_for_each([&](const CSVRow& row) {
+        outer_rows++;
+        if (row["A"].get<int>() % 10000 != 0)
+            return;
+
+        CSVReader inner(csv::in_memory, inner_csv, format);
+        for (auto& inner_row : inner) {
+            (void)inner_row;
+            inner_rows++;
+        }
+    });
+
+    REQUIRE(outer_rows == 100000);
+    REQUIRE(inner_rows == 10 * 5000);
+
+    remove(filename.c_str());
+}
+
+#ifdef CSV_HAS_COROUTINES
+namespace {
+    /** A coroutine which starts immediately and cleans up after itself */
+    struct DetachedTask {
+        struct promise_type {
+            DetachedTask get_return_object() { return {}; }
+            std::suspend_never initial_suspend() noexcept { return {}; }
+            std::suspend_never final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() { std::terminate(); }
+        };
+    };
+
+    DetachedTask read_batches(CSVReader& reader, CSVReader::Resumer resume,
+        vector<vector<string>>& rows, std::promise<void>& done) {
+        try {
+            while (true) {
+                RowBatch batch = co_await reader.next_batch(1000, resume);
+                if (batch.empty()) break;
+
+                for (auto& row : batch)
+                    rows.push_back(vector<string>(row));
+            }
+
+            done.set_value();
+        }
+        catch (...) {
+            done.set_exception(std::current_exception());
+        }
+    }
+}
+
+TEST_CASE("Read CSV from a Coroutine", "[read_csv_coroutine]") {
+    const string csv_string = compressible_csv();
+    const string filename = "coroutine.csv";
+    {
+        std::ofstream outfile(filename, std::ios::binary);
+        outfile << csv_string;
+    }
+
+    CSVReader default_reader(filename);
+    auto expected = read_rows(default_reader);
+
+    Executor executor(1);
+    CSVFormat format;
+    format.chunk_size(1 << 14).executor(executor);
+
+    SECTION("Resumed on the Executor") {
+        CSVReader reader(filename, format);
+        vector<vector<string>> rows;
+        std::promise<void> done;
+
+        read_batches(reader, nullptr, rows, done);
+        done.get_future().get();
+        REQUIRE(rows == expected);
+    }
+
+    SECTION("Resumed by an Event Loop") {
+        // A minimal event loop running on this thread
+        std::mutex lock;
+        std::condition_variable cond;
+        std::deque<std::coroutine_handle<>> ready;
+        auto resume = [&](std::coroutine_handle<> handle) {
+            std::lock_guard<std::mutex> guard(lock);
+            ready.push_back(handle);
+            cond.notify_one();
+        };
+
+        CSVReader reader(filename, format);
+        vector<vector<string>> rows;
+        std::promise<void> done;
+        auto finished = done.get_future();
+
+        read_batches(reader, resume, rows, done);
+        while (finished.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            std::unique_lock<std::mutex> guard(lock);
+            cond.wait(guard, [&] { return !ready.empty(); });
+            auto handle = ready.front();
+            ready.pop_front();
+            guard.unlock();
+
+            handle.resume();
+        }
+
+        finished.get();
+        REQUIRE(rows == expected);
+    }
+
+    SECTION("Every Available Row Dropped") {
+        // Whole chunks of malformed rows are dropped before the next good row
+        const string malformed_file = "coroutine_malformed.csv";
+        {
+            std::ofstream outfile(malformed_file, std::ios::binary);
+            outfile << "A,B,C\r\n1,2,3\r\n";
+            for (int i = 0; i < 200000; i++)
+                outfile << "x\r\n";
+            for (int i = 0; i < 1000; i++)
+                outfile << i << ",y,z\r\n";
+        }
+
+        CSVReader reader(malformed_file, CSVFormat(format).chunk_size(4096));
+        vector<vector<string>> rows;
+        std::promise<void> done;
+
+        read_batches(reader, nullptr, rows, done);
+        done.get_future().get();
+        REQUIRE(rows.size() == 1001);
+        REQUIRE(rows.front() == vector<string>({ "1", "2", "3" }));
+        REQUIRE(rows.back() == vector<string>({ "999", "y", "z" }));
+
+        remove(malformed_file.c_str());
+    }
+
+    remove(filename.c_str());
+}
+#endif
+
 TEST_CASE("Non-Existent CSV", "[read_ghost_csv]") {
     // Make sure attempting to parse a non-existent CSV throws an error
     bool error_caught = false;
@@ -68,4 +68,70 @@ TEST_CASE("Simple Integer Round Trip Test", "[test_roundtrip_int]") {
     REQUIRE(reader.n_rows() == n_rows);
 
     remove(filename);
-}
\ No newline at end of file
+}
+
+TEST_CASE("Parallel Parsing Round Trip Test", "[test_roundtrip_parallel]") {
+    auto filename = "round_trip_parallel.csv";
+    std::ofstream outfile(filename, std::ios::binary);
+    auto writer = make_csv_writer_buffered(outfile);
+
+    writer << std::vector<std::string>({ "A", "B", "C" });
+
+    const size_t n_rows = 100000;
+
+    for (size_t i = 0; i < n_rows; i++) {
+        auto str = internals::to_string(i);
+        writer << std::array<std::string, 3>({ str, "quoted, \"text\"\n" + str, str });
+    }
+    writer.flush();
+
+    // Each window is 2 * 64 KB, so this file spans many windows
+    CSVReader reader(filename, CSVFormat().parse_threads(2).chunk_size(1 << 16));
+
+    size_t i = 0;
+    for (auto& row : reader) {
+        auto str = internals::to_string(i);
+        REQUIRE(row["A"] == i);
+        REQUIRE(row["B"].get<std::string>() == "quoted, \"text\"\n" + str);
+        REQUIRE(row["C"] == i);
+        i++;
+    }
+
+    REQUIRE(reader.n_rows() == n_rows);
+
+    remove(filename);
+}
+
+TEST_CASE("Column Selection Round Trip Test", "[test_roundtrip_select_columns]") {
+    auto filename = "round_trip_select_columns.csv";
+    std::ofstream outfile(filename, std::ios::binary);
+    auto writer = make_csv_writer_buffered(outfile);
+
+    writer << std::vector<std::string>({ "A", "B", "C", "D" });
+
+    const size_t n_rows = 500000;
+
+    for (size_t i = 0; i < n_rows; i++) {
+        auto str = internals::to_string(i);
+        writer << std::array<std::string, 4>({ str, "quoted, \"text\"\n" + str, str, "x" });
+    }
+    writer.flush();
+
+    CSVFormat format;
+    format.select_columns({ "C", "B" }).parse_threads(2);
+    CSVReader reader(filename, format);
+    REQUIRE(reader.get_col_names() == std::vector<std::string>({ "B", "C" }));
+
+    size_t i = 0;
+    for (auto& row : reader) {
+        auto str = internals::to_string(i);
+        REQUIRE(row.size() == 2);
+        REQUIRE(row["B"].get<std::string>() == "quoted, \"text\"\n" + str);
+        REQUIRE(row["C"] == i);
+        i++;
+    }
+
+    REQUIRE(reader.n_rows() == n_rows);
+
+    remove(filename);
+}
@@ -0,0 +1,49 @@
+#include <catch2/catch_all.hpp>
+#include "internal/csv_simd.hpp"
+
+#include <string>
+#include <vector>
+
+using namespace csv::internals;
+
+namespace {
+    std::vector<FindSpecialFunc> find_special_impls() {
+        std::vector<FindSpecialFunc> impls = { &find_special_scalar };
+#ifdef CSV_HAS_SSE2
+        impls.push_back(&find_special_sse2);
+#endif
+#ifdef CSV_HAS_AVX2
+        if (cpu_has_avx2()) impls.push_back(&find_special_avx2);
+#endif
+        return impls;
+    }
+}
+
+TEST_CASE("find_special() Implementations Agree", "[test_find_special]") {
+    const SpecialChars chars = { ',', '"', '\n', '\r' };
+
+    // Place a special character at every offset (and past the end) of
+    // strings long enough to exercise all block sizes and the scalar tail
+    for (size_t length : { 0, 1, 15, 16, 17, 31, 32, 33, 63, 64, 65, 130 }) {
+        for (size_t pos = 0; pos <= length; pos++) {
+            std::string in(length, 'x');
+            if (pos < length) in[pos] = chars[pos % chars.size()];
+
+            for (auto impl : find_special_impls()) {
+                auto result = impl(in.data(), in.data() + in.size(), chars);
+                REQUIRE((size_t)(result - in.data()) == pos);
+            }
+        }
+    }
+}
+
+TEST_CASE("find_special() Handles Non-ASCII Bytes", "[test_find_special_high_bit]") {
+    const SpecialChars chars = { '\xAC', '\xAC', '\xAC', '\xAC' };
+    std::string in = std::string(40, '\xAB') + "\xAC";
+
+    for (auto impl : find_special_impls()) {
+        REQUIRE(impl(in.data(), in.data() + in.size(), chars) == in.data() + 40);
+    }
+
+    REQUIRE(find_special_func()(in.data(), in.data() + in.size(), chars) == in.data() + 40);
+}